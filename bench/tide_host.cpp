@@ -0,0 +1,393 @@
+/**
+ * tide_host: headless multi-instance DSP host for tide~
+ *
+ * Loads the real tide~ object code through the Max API stand-in (maxshim),
+ * creates up to max_instances objects, compiles their DSP with dsp64 and runs
+ * their perform routines in one chain, advancing the scheduler clock by a
+ * vector each tick, or once per I/O buffer with --io-buffer as Max does when
+ * the buffer is larger than the signal vector. For a sweep of instance counts it reports
+ * CPU% of real time and nanoseconds per sample per instance, plus the number
+ * of instances one core could run at 100% (capacity).
+ *
+ * Signal buffers are recycled as in an MSP chain: outputs rotate through a
+ * small pool, so the figures show the objects' own state traffic rather than
+ * the host's.
+ *
+ * In builds with TIDE_ENABLE_STATS and TIDES_STAGE_PROFILING, each count is
+ * followed by the chain's split between ramp generation, shaping and
+ * smoothing, collected from every instance's stats dictionary.
+ *
+ * With a trace_file, builds with TIDE_ENABLE_TRACE record the timed run of
+ * the largest count with "trace start" / "trace stop" and write it there as
+ * Chrome trace JSON.
+ *
+ * A sync check first renders one instance for ten seconds and fails unless
+ * the phase holds: with --io-buffer, the bursty clock must end on the same
+ * output as a per-vector clock. Under the chosen clock, a 3 Hz LFO whose
+ * perform is not called for a span of vectors (as for a muted poly~ voice),
+ * mid-run or from DSP start, must end where an uninterrupted one does.
+ *
+ * With --baseline, each count's ns/sample/instance is written to a baseline
+ * file (tides_baseline.h); one sample per run, so repeat the run and pass
+ * every file to tides_compare.
+ *
+ * Usage: tide_host [max_instances] [sample_rate] [vector_size] [audio_seconds] [float|signal] [trace_file]
+ *                  [--io-buffer samples] [--baseline file]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "maxshim.h"
+#include "tides_baseline.h"
+#include "tides_wrapper.h"
+
+namespace {
+
+const int kInlets = 5;
+const int kOutputBuffers = 16;
+const double kMaxWorkSamples = 5.0e7;   // Instance-samples per measurement
+const long kMinVectors = 16;
+const double kSyncSeconds = 10.0;
+const long kGapVectors = 777;           // Vectors left out by the sync check's gaps
+const double kGapTolerance = 1e-6;      // The catch-up advances the phase analytically
+
+// Drops the console output of tide~ except the trace recorder's reports
+void QuietPost(const char* line, void*) {
+    if (strncmp(line, "tide~: trace", 12) == 0) {
+        fprintf(stderr, "%s\n", line);
+    }
+}
+
+struct Chain {
+    std::vector<void*> objects;
+    std::vector<t_maxshim_dsp*> dsps;
+};
+
+// Stage profile summed over the chain from tide~'s stats dictionaries
+struct StageTotals {
+    bool available;
+    std::string unit;
+    double samples;
+    double ramp;
+    double shaping;
+    double smoothing;
+    double shape_regions[TIDES_SHAPE_REGIONS];
+    double smooth_regions[TIDES_SMOOTH_REGIONS];
+};
+
+double AtomAt(t_dictionary* d, const char* key, long index) {
+    long argc = 0;
+    t_atom* argv = NULL;
+    if (dictionary_getatoms(d, gensym(key), &argc, &argv) != MAX_ERR_NONE || index >= argc) {
+        return 0.0;
+    }
+    return (double)atom_getlong(argv + index);
+}
+
+void CollectStats(void*, long, t_symbol* s, long argc, t_atom* argv, void* context) {
+    StageTotals* totals = static_cast<StageTotals*>(context);
+    if (s != gensym("dictionary") || argc < 1) {
+        return;
+    }
+    t_dictionary* d = dictobj_findregistered_retain(atom_getsym(argv));
+    t_symbol* unit = NULL;
+    if (d && dictionary_getsym(d, gensym("stage_unit"), &unit) == MAX_ERR_NONE) {
+        totals->available = true;
+        totals->unit = unit->s_name;
+        totals->samples += AtomAt(d, "stage_samples", 0);
+        totals->ramp += AtomAt(d, "stage_ramp", 0);
+        totals->shaping += AtomAt(d, "stage_shaping", 0);
+        totals->smoothing += AtomAt(d, "stage_smoothing", 0);
+        for (int i = 0; i < TIDES_SHAPE_REGIONS; i++) {
+            totals->shape_regions[i] += AtomAt(d, "shape_regions", i);
+        }
+        for (int i = 0; i < TIDES_SMOOTH_REGIONS; i++) {
+            totals->smooth_regions[i] += AtomAt(d, "smooth_regions", i);
+        }
+    }
+    if (d) {
+        dictobj_release(d);
+    }
+}
+
+void PrintStages(Chain* chain) {
+    StageTotals totals = StageTotals();
+    maxshim_set_outlet_hook(CollectStats, &totals);
+    for (size_t i = 0; i < chain->objects.size(); i++) {
+        maxshim_message(chain->objects[i], 0, "stats", 0, NULL);
+    }
+    maxshim_set_outlet_hook(NULL, NULL);
+    if (!totals.available || totals.samples <= 0.0) {
+        return;
+    }
+
+    double n = totals.samples;
+    double stages = std::max(totals.ramp + totals.shaping + totals.smoothing, 1.0);
+    printf("%10s ramp %.1f / shaping %.1f / smoothing %.1f %s per sample (%.0f%% / %.0f%% / %.0f%%)\n", "",
+           totals.ramp / n, totals.shaping / n, totals.smoothing / n, totals.unit.c_str(),
+           100.0 * totals.ramp / stages, 100.0 * totals.shaping / stages, 100.0 * totals.smoothing / stages);
+    printf("%10s shape linear/exp/log %.0f%%/%.0f%%/%.0f%%, smooth none/filter/fold %.0f%%/%.0f%%/%.0f%%\n", "",
+           100.0 * totals.shape_regions[TIDES_SHAPE_LINEAR] / n,
+           100.0 * totals.shape_regions[TIDES_SHAPE_EXPONENTIAL] / n,
+           100.0 * totals.shape_regions[TIDES_SHAPE_LOGARITHMIC] / n,
+           100.0 * totals.smooth_regions[TIDES_SMOOTH_NONE] / n,
+           100.0 * totals.smooth_regions[TIDES_SMOOTH_FILTER] / n,
+           100.0 * totals.smooth_regions[TIDES_SMOOTH_FOLD] / n);
+}
+
+void BuildChain(Chain* chain, long instances, double sample_rate, long vector_size, bool signal_inputs) {
+    short count[kInlets + 1];
+    for (int i = 0; i < kInlets; i++) {
+        count[i] = signal_inputs ? 1 : 0;
+    }
+    count[kInlets] = 1;  // Outlet connected
+
+    for (long i = 0; i < instances; i++) {
+        void* x = maxshim_new("tide~", 0, NULL);
+        if (!x) {
+            break;
+        }
+        // Spread instances over rates and shapes, like a patch full of LFOs
+        maxshim_float(x, 0, 0.1 + (double)(i % 97) * 0.37);
+        maxshim_float(x, 1, (double)(i % 11) / 10.0);
+        maxshim_float(x, 2, 0.05 + 0.9 * (double)((i * 7) % 10) / 9.0);
+        maxshim_float(x, 3, (double)((i * 3) % 11) / 10.0);
+        chain->objects.push_back(x);
+        chain->dsps.push_back(maxshim_dsp_new(x, count, sample_rate, vector_size));
+    }
+}
+
+void FreeChain(Chain* chain) {
+    for (size_t i = 0; i < chain->objects.size(); i++) {
+        maxshim_dsp_free(chain->dsps[i]);
+        maxshim_free(chain->objects[i]);
+    }
+    chain->objects.clear();
+    chain->dsps.clear();
+}
+
+// Zeroes stats counters at each instance's next vector (no-op without stats)
+void ClearStats(Chain* chain) {
+    t_atom clear;
+    atom_setsym(&clear, gensym("clear"));
+    for (size_t i = 0; i < chain->objects.size(); i++) {
+        maxshim_message(chain->objects[i], 0, "stats", 1, &clear);
+    }
+}
+
+// Runs vectors ticks of the whole chain, setting the scheduler clock every
+// io_vectors ticks and leaving perform out from tick skip_begin to skip_end - 1;
+// returns wall seconds
+double RunChain(Chain* chain, long vectors, double sample_rate, long vector_size, long io_vectors,
+                std::vector<double>* inputs, std::vector<double>* outputs,
+                long skip_begin = 0, long skip_end = 0) {
+    double* ins[kInlets];
+    for (int i = 0; i < kInlets; i++) {
+        ins[i] = inputs->data() + i * vector_size;
+    }
+    double vector_ms = 1000.0 * vector_size / sample_rate;
+    double origin = maxshim_gettime();
+
+    auto start = std::chrono::steady_clock::now();
+    for (long v = 0; v < vectors; v++) {
+        if (v % io_vectors == 0) {
+            maxshim_settime(origin + (double)v * vector_ms);
+        }
+        if (v >= skip_begin && v < skip_end) {
+            continue;
+        }
+        for (size_t i = 0; i < chain->dsps.size(); i++) {
+            double* outs[1] = { outputs->data() + (i % kOutputBuffers) * vector_size };
+            maxshim_dsp_tick(chain->dsps[i], ins, outs, vector_size);
+        }
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    maxshim_settime(origin + (double)vectors * vector_ms);
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+// Renders one instance for kSyncSeconds and returns its last vector
+std::vector<double> SyncRun(double sample_rate, long vector_size, long io_vectors, bool signal_inputs,
+                            double frequency, long skip_begin, long skip_end, std::vector<double>* inputs) {
+    long vectors = (long)(kSyncSeconds * sample_rate / vector_size);
+    std::vector<double> outputs(kOutputBuffers * vector_size, 0.0);
+    Chain chain;
+    BuildChain(&chain, 1, sample_rate, vector_size, signal_inputs);
+    if (chain.objects.empty()) {
+        return std::vector<double>();
+    }
+    if (frequency > 0.0) {
+        maxshim_float(chain.objects[0], 0, frequency);
+    }
+    RunChain(&chain, vectors, sample_rate, vector_size, io_vectors, inputs, &outputs, skip_begin, skip_end);
+    FreeChain(&chain);
+    outputs.resize(vector_size);
+    return outputs;
+}
+
+// Largest difference between two last vectors, or -1 if either run failed
+double MaxDifference(const std::vector<double>& a, const std::vector<double>& b) {
+    if (a.empty() || a.size() != b.size()) {
+        return -1.0;
+    }
+    double diff = 0.0;
+    for (size_t i = 0; i < a.size(); i++) {
+        diff = std::max(diff, std::fabs(a[i] - b[i]));
+    }
+    return diff;
+}
+
+// Runs the sync checks and prints each; returns false if one failed
+bool SyncCheck(double sample_rate, long vector_size, long io_vectors, bool signal_inputs,
+               std::vector<double>* inputs) {
+    bool ok = true;
+    if (io_vectors > 1) {
+        double diff = MaxDifference(SyncRun(sample_rate, vector_size, io_vectors, signal_inputs, 0.0, 0, 0, inputs),
+                                    SyncRun(sample_rate, vector_size, 1, signal_inputs, 0.0, 0, 0, inputs));
+        printf("sync check: %.0f s under bursty vs per-vector clock, max difference %g\n", kSyncSeconds, diff);
+        if (diff != 0.0) {
+            fprintf(stderr, "tide_host: scheduler bursts moved the phase\n");
+            ok = false;
+        }
+    }
+    
+    // Gaps start and end on a clock update, where the catch-up is exact; the
+    // catch-up follows the float frequency, so the inlets take floats
+    long gap = (kGapVectors + io_vectors - 1) / io_vectors * io_vectors;
+    long middle = (long)(kSyncSeconds * sample_rate / vector_size) / 2 / io_vectors * io_vectors;
+    std::vector<double> reference = SyncRun(sample_rate, vector_size, io_vectors, false, 3.0, 0, 0, inputs);
+    const long begins[] = { middle, 0 };
+    const char* const names[] = { "mid-run", "from DSP start" };
+    for (int g = 0; g < 2; g++) {
+        double diff = MaxDifference(SyncRun(sample_rate, vector_size, io_vectors, false, 3.0,
+                                            begins[g], begins[g] + gap, inputs), reference);
+        printf("sync check: perform left out for %ld vectors %s, max difference %g\n", gap, names[g], diff);
+        if (diff < 0.0 || diff > kGapTolerance) {
+            fprintf(stderr, "tide_host: the phase did not catch up across a gap %s\n", names[g]);
+            ok = false;
+        }
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    tides_baseline::Baseline baseline("tide_host", &argc, argv);
+    long io_buffer = 0;
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--io-buffer") == 0 && i + 1 < argc) {
+            io_buffer = atol(argv[++i]);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    long max_instances = argc > 1 ? atol(argv[1]) : 100000;
+    double sample_rate = argc > 2 ? atof(argv[2]) : 48000.0;
+    long vector_size = argc > 3 ? atol(argv[3]) : 64;
+    double audio_seconds = argc > 4 ? atof(argv[4]) : 1.0;
+    bool signal_inputs = argc > 5 && strcmp(argv[5], "signal") == 0;
+    const char* trace_file = argc > 6 ? argv[6] : NULL;
+
+    if (max_instances < 1 || sample_rate <= 0.0 || vector_size < 1 || audio_seconds <= 0.0
+        || (argc > 5 && !signal_inputs && strcmp(argv[5], "float") != 0)
+        || io_buffer < 0 || (io_buffer && io_buffer % vector_size != 0)) {
+        fprintf(stderr, "usage: tide_host [max_instances] [sample_rate] [vector_size] [audio_seconds] [float|signal] [trace_file] [--io-buffer samples] [--baseline file]\n"
+                        "       (the I/O buffer is a multiple of the vector size)\n");
+        return 2;
+    }
+    long io_vectors = io_buffer ? io_buffer / vector_size : 1;
+
+    maxshim_set_post_hook(QuietPost, NULL);
+    ext_main(NULL);
+
+    // Signal inputs hold audio-rate modulation in every inlet
+    std::vector<double> inputs(kInlets * vector_size);
+    for (long i = 0; i < vector_size; i++) {
+        inputs[i] = 2.0 + (double)(i % 7);
+        inputs[vector_size + i] = 0.3;
+        inputs[2 * vector_size + i] = 0.4;
+        inputs[3 * vector_size + i] = 0.2;
+        inputs[4 * vector_size + i] = 0.0;
+    }
+    std::vector<double> outputs(kOutputBuffers * vector_size);
+
+    printf("tide_host: up to %ld instances, %.0f Hz, vector %ld, I/O buffer %ld, %s inputs\n",
+           max_instances, sample_rate, vector_size, io_vectors * vector_size, signal_inputs ? "signal" : "float");
+    if (!SyncCheck(sample_rate, vector_size, io_vectors, signal_inputs, &inputs)) {
+        return 1;
+    }
+    printf("%10s %10s %12s %10s %16s %12s\n",
+           "instances", "vectors", "audio_ms", "cpu_pct", "ns/sample/inst", "capacity");
+
+    // 1, 2, 5, 10, 20, 50, ... up to max_instances
+    std::vector<long> counts;
+    for (long decade = 1; decade <= max_instances; decade *= 10) {
+        const long steps[] = { 1, 2, 5 };
+        for (int s = 0; s < 3; s++) {
+            if (decade * steps[s] <= max_instances) {
+                counts.push_back(decade * steps[s]);
+            }
+        }
+    }
+    if (counts.back() != max_instances) {
+        counts.push_back(max_instances);
+    }
+
+    for (size_t c = 0; c < counts.size(); c++) {
+        long instances = counts[c];
+        Chain chain;
+        BuildChain(&chain, instances, sample_rate, vector_size, signal_inputs);
+        if ((long)chain.objects.size() != instances) {
+            fprintf(stderr, "tide_host: could only create %zu instances\n", chain.objects.size());
+            FreeChain(&chain);
+            return 1;
+        }
+
+        long vectors = (long)(audio_seconds * sample_rate / vector_size);
+        long work_cap = (long)(kMaxWorkSamples / ((double)instances * vector_size));
+        vectors = std::max(kMinVectors, std::min(vectors, work_cap));
+
+        RunChain(&chain, kMinVectors, sample_rate, vector_size, io_vectors, &inputs, &outputs);  // Warm up
+        ClearStats(&chain);
+        bool tracing = trace_file && c + 1 == counts.size();
+        if (tracing) {
+            t_atom start;
+            atom_setsym(&start, gensym("start"));
+            if (maxshim_message(chain.objects[0], 0, "trace", 1, &start) != MAX_ERR_NONE) {
+                fprintf(stderr, "tide_host: tide~ was built without TIDE_ENABLE_TRACE\n");
+                tracing = false;
+            }
+        }
+        double seconds = RunChain(&chain, vectors, sample_rate, vector_size, io_vectors, &inputs, &outputs);
+        if (tracing) {
+            t_atom stop[2];
+            atom_setsym(&stop[0], gensym("stop"));
+            atom_setsym(&stop[1], gensym(trace_file));
+            maxshim_message(chain.objects[0], 0, "trace", 2, stop);
+        }
+
+        double audio_ms = 1000.0 * vectors * vector_size / sample_rate;
+        double cpu_pct = 100.0 * seconds * 1000.0 / audio_ms;
+        double ns_per_sample = seconds * 1e9 / ((double)vectors * vector_size * instances);
+        printf("%10ld %10ld %12.1f %10.2f %16.2f %12.0f\n",
+               instances, vectors, audio_ms, cpu_pct, ns_per_sample, instances * 100.0 / cpu_pct);
+        baseline.Add("instances/" + std::to_string(instances), "ns_per_sample", ns_per_sample);
+        PrintStages(&chain);
+
+        FreeChain(&chain);
+    }
+
+    maxshim_quit();     // Waits for the trace writer
+    return baseline.Write() ? 0 : 1;
+}
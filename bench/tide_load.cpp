@@ -0,0 +1,212 @@
+/**
+ * tide_load: instantiation and patch-load benchmark for tide~
+ *
+ * Loading a patch creates every object (tide_new: object_alloc, dsp_setup,
+ * outlets, the Tides core and attr_args_process), compiles the DSP chain and
+ * renders a first vector; closing it frees them again. This runs those phases
+ * for a bank of instances through the Max API stand-in (maxshim) and reports,
+ * per phase, the time for the whole bank and per instance (median and best of
+ * several rounds), plus the memory each instance holds once created and once
+ * its DSP is compiled:
+ *
+ *   create         maxshim_new("tide~", "@freqscale 0.5"), as a saved patch does
+ *   dsp            dsp64 with the outlet connected
+ *   first_vector   one 64-sample vector per instance (first touch of DSP state)
+ *   free           DSP chain and object freed
+ *
+ * Memory is the growth of the C heap in use (glibc mallinfo2) and of the
+ * resident set (Linux /proc/self/statm), divided by the instance count; "-"
+ * where the platform offers neither.
+ *
+ * With --baseline, every round's ns per instance is written to a baseline file
+ * (tides_baseline.h).
+ *
+ * Usage: tide_load [instances] [rounds] [--baseline file]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#if defined(__GLIBC__) || defined(__linux__)
+#include <malloc.h>
+#include <unistd.h>
+#endif
+
+#include "maxshim.h"
+#include "tides_baseline.h"
+
+namespace {
+
+const double kSampleRate = 48000.0;
+const long kVectorSize = 64;
+const int kInlets = 5;
+
+enum Phase { kCreate, kDsp, kFirstVector, kFree, kPhases };
+const char* const kPhaseNames[kPhases] = { "create", "dsp", "first_vector", "free" };
+
+void QuietPost(const char*, void*) {}
+
+// C heap bytes in use, or -1
+double HeapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return (double)mallinfo2().uordblks;
+#else
+    return -1.0;
+#endif
+}
+
+// Resident set in bytes, or -1
+double ResidentBytes() {
+#ifdef __linux__
+    FILE* statm = fopen("/proc/self/statm", "r");
+    long size = 0, resident = -1;
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &size, &resident) != 2) {
+            resident = -1;
+        }
+        fclose(statm);
+    }
+    return resident < 0 ? -1.0 : (double)resident * (double)sysconf(_SC_PAGESIZE);
+#else
+    return -1.0;
+#endif
+}
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Round {
+    double seconds[kPhases];
+    double heap_created;                // Bytes per instance
+    double heap_compiled;
+    double resident_compiled;
+    long created;
+};
+
+Round LoadRound(long instances) {
+    Round round;
+    std::vector<void*> objects;
+    std::vector<t_maxshim_dsp*> dsps;
+    objects.reserve(instances);
+    dsps.reserve(instances);
+
+    t_atom args[2];
+    atom_setsym(&args[0], gensym("@freqscale"));
+    atom_setfloat(&args[1], 0.5);
+
+    double heap = HeapBytes();
+    double resident = ResidentBytes();
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (long i = 0; i < instances; i++) {
+        void* x = maxshim_new("tide~", 2, args);
+        if (!x) {
+            break;
+        }
+        objects.push_back(x);
+    }
+    round.seconds[kCreate] = Seconds(start);
+    round.created = (long)objects.size();
+    double n = (double)std::max(1L, round.created);
+    round.heap_created = heap < 0.0 ? -1.0 : (HeapBytes() - heap) / n;
+
+    short count[kInlets + 1] = { 0, 0, 0, 0, 0, 1 };   // Outlet connected
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < objects.size(); i++) {
+        dsps.push_back(maxshim_dsp_new(objects[i], count, kSampleRate, kVectorSize));
+    }
+    round.seconds[kDsp] = Seconds(start);
+
+    std::vector<double> buffer(kInlets * kVectorSize + kVectorSize, 0.0);
+    double* ins[kInlets];
+    for (int i = 0; i < kInlets; i++) {
+        ins[i] = buffer.data() + i * kVectorSize;
+    }
+    double* outs[1] = { buffer.data() + kInlets * kVectorSize };
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < dsps.size(); i++) {
+        maxshim_dsp_tick(dsps[i], ins, outs, kVectorSize);
+    }
+    round.seconds[kFirstVector] = Seconds(start);
+    round.heap_compiled = heap < 0.0 ? -1.0 : (HeapBytes() - heap) / n;
+    round.resident_compiled = resident < 0.0 ? -1.0 : (ResidentBytes() - resident) / n;
+
+    start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < objects.size(); i++) {
+        maxshim_dsp_free(dsps[i]);
+        maxshim_free(objects[i]);
+    }
+    round.seconds[kFree] = Seconds(start);
+    return round;
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    tides_baseline::Baseline baseline("tide_load", &argc, argv);
+    long instances = argc > 1 ? atol(argv[1]) : 10000;
+    int rounds = argc > 2 ? atoi(argv[2]) : 7;
+
+    if (instances < 1 || rounds < 1) {
+        fprintf(stderr, "usage: tide_load [instances] [rounds] [--baseline file]\n");
+        return 2;
+    }
+
+    maxshim_set_post_hook(QuietPost, NULL);
+    ext_main(NULL);
+
+    std::vector<Round> results;
+    for (int r = 0; r < rounds; r++) {
+        results.push_back(LoadRound(instances));
+        if (results.back().created != instances) {
+            fprintf(stderr, "tide_load: could only create %ld instances\n", results.back().created);
+            return 1;
+        }
+    }
+
+    printf("tide_load: %ld instances, %d rounds (median / best)\n", instances, rounds);
+    printf("%-14s %12s %12s %14s %14s\n", "phase", "ms_median", "ms_best", "ns/inst_median", "ns/inst_best");
+    double load_median = 0.0;
+    for (int p = 0; p < kPhases; p++) {
+        std::vector<double> seconds;
+        for (size_t r = 0; r < results.size(); r++) {
+            seconds.push_back(results[r].seconds[p]);
+            baseline.Add(kPhaseNames[p], "ns_per_instance", results[r].seconds[p] * 1e9 / (double)instances);
+        }
+        double median = Median(seconds);
+        double best = *std::min_element(seconds.begin(), seconds.end());
+        if (p != kFree) {
+            load_median += median;
+        }
+        printf("%-14s %12.3f %12.3f %14.1f %14.1f\n", kPhaseNames[p], median * 1e3, best * 1e3,
+               median * 1e9 / (double)instances, best * 1e9 / (double)instances);
+    }
+    printf("patch load (create + dsp + first vector): %.3f ms median\n", load_median * 1e3);
+
+    // Memory from the first round: later rounds reuse the heap the first one grew
+    const Round& first = results[0];
+    if (first.heap_created >= 0.0) {
+        printf("heap per instance: %.0f bytes created, %.0f bytes with DSP compiled\n",
+               first.heap_created, first.heap_compiled);
+    } else {
+        printf("heap per instance: -\n");
+    }
+    if (first.resident_compiled >= 0.0) {
+        printf("resident per instance: %.0f bytes\n", first.resident_compiled);
+    } else {
+        printf("resident per instance: -\n");
+    }
+
+    maxshim_quit();
+    return baseline.Write() ? 0 : 1;
+}
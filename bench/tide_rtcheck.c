@@ -0,0 +1,522 @@
+/**
+ * tide_rtcheck: real-time safety check of the tide~ perform path
+ *
+ * Replaces the allocator, the pthread mutex functions, stdio and common system
+ * calls with versions that fail while a perform routine runs, as does Max's
+ * post() (which allocates and locks in Max), then drives tide~
+ * through the maxshim host interface over every path perform takes: float and
+ * signal inputs, the small-vector routine, events mid-vector, a flooded event
+ * queue, mute, scheduler gaps, a scheduler clock that moves once per I/O
+ * buffer, stats and trace recording when built in. A
+ * forbidden call prints the function, the scenario and a backtrace and exits
+ * with status 1; otherwise every scenario prints "ok" and the exit status is 0.
+ *
+ * Only the audio thread is checked, and only inside maxshim_dsp_tick: messages,
+ * DSP compilation and the trace writer may allocate and lock as in Max.
+ *
+ * Linux and glibc only: the allocator forwards to glibc's __libc_* entry points
+ * and everything else through dlsym(RTLD_NEXT). Calls glibc makes internally
+ * (stdio's own write, for instance) bypass the interposed symbols, hence the
+ * stdio entry points are checked themselves.
+ *
+ * Usage: tide_rtcheck
+ */
+
+#define _GNU_SOURCE
+#undef _FORTIFY_SOURCE      // Keeps the stdio functions below from being inline wrappers
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "maxshim.h"
+
+#define RTCHECK_INSTANCES 8
+#define RTCHECK_VECTORS 600
+#define RTCHECK_INLETS 5
+#define RTCHECK_MAX_VECTOR 64
+#define RTCHECK_BACKTRACE 64
+
+// glibc's allocator, under the names it exports for interposers
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+extern void* __libc_memalign(size_t alignment, size_t size);
+extern void __libc_free(void* ptr);
+
+// Set by the host thread around each perform call
+static _Thread_local int rtcheck_armed = 0;
+static const char* rtcheck_scenario = "startup";
+static long rtcheck_calls_seen = 0;
+
+//----------------------------------------------------------------------------------------------
+
+static void rtcheck_fail(const char* function)
+{
+    // Disarm first: reporting may itself call what is being checked
+    void* frames[RTCHECK_BACKTRACE];
+    char line[256];
+
+    rtcheck_armed = 0;
+    int length = snprintf(line, sizeof(line), "tide_rtcheck: %s called from the perform path (scenario: %s)\n",
+                          function, rtcheck_scenario);
+    if (length > 0) {
+        ssize_t unused = write(STDERR_FILENO, line, (size_t)length);
+        (void)unused;
+    }
+    int depth = backtrace(frames, RTCHECK_BACKTRACE);
+    backtrace_symbols_fd(frames, depth, STDERR_FILENO);
+    _exit(1);
+}
+
+// Entry of every interposed function
+#define RTCHECK_ENTER(function) \
+    do { \
+        if (rtcheck_armed) { \
+            rtcheck_fail(function); \
+        } \
+        rtcheck_calls_seen++; \
+    } while (0)
+
+// Next definition of a libc function, looked up on first use
+#define RTCHECK_REAL(function) \
+    static __typeof__(&function) real_##function = NULL; \
+    if (!real_##function) { \
+        real_##function = (__typeof__(&function))dlsym(RTLD_NEXT, #function); \
+    }
+
+//----------------------------------------------------------------------------------------------
+// Allocator
+
+void* malloc(size_t size)
+{
+    RTCHECK_ENTER("malloc");
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+    RTCHECK_ENTER("calloc");
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+    RTCHECK_ENTER("realloc");
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr)
+{
+    RTCHECK_ENTER("free");
+    __libc_free(ptr);
+}
+
+int posix_memalign(void** ptr, size_t alignment, size_t size)
+{
+    RTCHECK_ENTER("posix_memalign");
+    void* block = __libc_memalign(alignment, size);
+    if (!block) {
+        return ENOMEM;
+    }
+    *ptr = block;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size)
+{
+    RTCHECK_ENTER("aligned_alloc");
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size)
+{
+    RTCHECK_ENTER("memalign");
+    return __libc_memalign(alignment, size);
+}
+
+//----------------------------------------------------------------------------------------------
+// Locks
+
+int pthread_mutex_lock(pthread_mutex_t* mutex)
+{
+    RTCHECK_ENTER("pthread_mutex_lock");
+    RTCHECK_REAL(pthread_mutex_lock);
+    return real_pthread_mutex_lock(mutex);
+}
+
+int pthread_mutex_trylock(pthread_mutex_t* mutex)
+{
+    RTCHECK_ENTER("pthread_mutex_trylock");
+    RTCHECK_REAL(pthread_mutex_trylock);
+    return real_pthread_mutex_trylock(mutex);
+}
+
+int pthread_mutex_unlock(pthread_mutex_t* mutex)
+{
+    RTCHECK_ENTER("pthread_mutex_unlock");
+    RTCHECK_REAL(pthread_mutex_unlock);
+    return real_pthread_mutex_unlock(mutex);
+}
+
+int pthread_cond_wait(pthread_cond_t* cond, pthread_mutex_t* mutex)
+{
+    RTCHECK_ENTER("pthread_cond_wait");
+    RTCHECK_REAL(pthread_cond_wait);
+    return real_pthread_cond_wait(cond, mutex);
+}
+
+//----------------------------------------------------------------------------------------------
+// stdio
+
+int vfprintf(FILE* stream, const char* format, va_list args)
+{
+    RTCHECK_ENTER("vfprintf");
+    RTCHECK_REAL(vfprintf);
+    return real_vfprintf(stream, format, args);
+}
+
+int fprintf(FILE* stream, const char* format, ...)
+{
+    RTCHECK_ENTER("fprintf");
+    RTCHECK_REAL(vfprintf);
+    va_list args;
+    va_start(args, format);
+    int result = real_vfprintf(stream, format, args);
+    va_end(args);
+    return result;
+}
+
+int printf(const char* format, ...)
+{
+    RTCHECK_ENTER("printf");
+    RTCHECK_REAL(vfprintf);
+    va_list args;
+    va_start(args, format);
+    int result = real_vfprintf(stdout, format, args);
+    va_end(args);
+    return result;
+}
+
+int puts(const char* s)
+{
+    RTCHECK_ENTER("puts");
+    RTCHECK_REAL(puts);
+    return real_puts(s);
+}
+
+int fputs(const char* s, FILE* stream)
+{
+    RTCHECK_ENTER("fputs");
+    RTCHECK_REAL(fputs);
+    return real_fputs(s, stream);
+}
+
+size_t fwrite(const void* buffer, size_t size, size_t count, FILE* stream)
+{
+    RTCHECK_ENTER("fwrite");
+    RTCHECK_REAL(fwrite);
+    return real_fwrite(buffer, size, count, stream);
+}
+
+FILE* fopen(const char* path, const char* mode)
+{
+    RTCHECK_ENTER("fopen");
+    RTCHECK_REAL(fopen);
+    return real_fopen(path, mode);
+}
+
+int fflush(FILE* stream)
+{
+    RTCHECK_ENTER("fflush");
+    RTCHECK_REAL(fflush);
+    return real_fflush(stream);
+}
+
+//----------------------------------------------------------------------------------------------
+// System calls
+
+ssize_t read(int fd, void* buffer, size_t count)
+{
+    RTCHECK_ENTER("read");
+    RTCHECK_REAL(read);
+    return real_read(fd, buffer, count);
+}
+
+ssize_t write(int fd, const void* buffer, size_t count)
+{
+    RTCHECK_ENTER("write");
+    RTCHECK_REAL(write);
+    return real_write(fd, buffer, count);
+}
+
+int open(const char* path, int flags, ...)
+{
+    RTCHECK_ENTER("open");
+    RTCHECK_REAL(open);
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = (flags & (O_CREAT | O_TMPFILE)) ? (mode_t)va_arg(args, int) : 0;
+    va_end(args);
+    return real_open(path, flags, mode);
+}
+
+int openat(int dirfd, const char* path, int flags, ...)
+{
+    RTCHECK_ENTER("openat");
+    RTCHECK_REAL(openat);
+    va_list args;
+    va_start(args, flags);
+    mode_t mode = (flags & (O_CREAT | O_TMPFILE)) ? (mode_t)va_arg(args, int) : 0;
+    va_end(args);
+    return real_openat(dirfd, path, flags, mode);
+}
+
+int close(int fd)
+{
+    RTCHECK_ENTER("close");
+    RTCHECK_REAL(close);
+    return real_close(fd);
+}
+
+void* mmap(void* addr, size_t length, int prot, int flags, int fd, off_t offset)
+{
+    RTCHECK_ENTER("mmap");
+    RTCHECK_REAL(mmap);
+    return real_mmap(addr, length, prot, flags, fd, offset);
+}
+
+int munmap(void* addr, size_t length)
+{
+    RTCHECK_ENTER("munmap");
+    RTCHECK_REAL(munmap);
+    return real_munmap(addr, length);
+}
+
+int nanosleep(const struct timespec* request, struct timespec* remaining)
+{
+    RTCHECK_ENTER("nanosleep");
+    RTCHECK_REAL(nanosleep);
+    return real_nanosleep(request, remaining);
+}
+
+int usleep(useconds_t usec)
+{
+    RTCHECK_ENTER("usleep");
+    RTCHECK_REAL(usleep);
+    return real_usleep(usec);
+}
+
+int sched_yield(void)
+{
+    RTCHECK_ENTER("sched_yield");
+    RTCHECK_REAL(sched_yield);
+    return real_sched_yield();
+}
+
+long syscall(long number, ...)
+{
+    // Raw system calls, futex among them
+    RTCHECK_ENTER("syscall");
+    RTCHECK_REAL(syscall);
+    va_list args;
+    long a[6];
+    va_start(args, number);
+    for (int i = 0; i < 6; i++) {
+        a[i] = va_arg(args, long);
+    }
+    va_end(args);
+    return real_syscall(number, a[0], a[1], a[2], a[3], a[4], a[5]);
+}
+
+//----------------------------------------------------------------------------------------------
+// Host
+
+typedef struct _rtcheck_scenario
+{
+    const char* name;
+    long vector_size;
+    int signal_inputs;              // Every inlet connected to a signal
+    int messages;                   // Floats, bangs and attribute changes between vectors
+    int flood;                      // More floats per vector than the event queue holds
+    int mute;                       // Mute and unmute now and then
+    int gaps;                       // Jump the scheduler clock forward now and then
+    long io_vectors;                // Vectors per scheduler clock update (one I/O buffer)
+} t_rtcheck_scenario;
+
+static const t_rtcheck_scenario rtcheck_scenarios[] = {
+    { "float inputs, vector 64",            64, 0, 0, 0, 0, 0,  1 },
+    { "float inputs with messages",         64, 0, 1, 0, 0, 0,  1 },
+    { "signal inputs with messages",        64, 1, 1, 0, 0, 0,  1 },
+    { "small vectors with messages",         4, 0, 1, 0, 0, 0,  1 },
+    { "small vectors, signal inputs",        1, 1, 0, 0, 0, 0,  1 },
+    { "flooded event queue",                64, 0, 1, 1, 0, 0,  1 },
+    { "mute and scheduler gaps",            64, 0, 1, 0, 1, 1,  1 },
+    { "small vectors, mute and gaps",       16, 1, 1, 1, 1, 1,  1 },
+    { "bursty clock, 1024-sample I/O",      64, 0, 1, 0, 1, 1, 16 },
+    { "small vectors, bursty clock",        16, 1, 1, 0, 1, 1, 64 },
+};
+
+static void rtcheck_post(const char* line, void* context)
+{
+    // Max's post allocates and takes a lock; elsewhere its output is dropped
+    if (rtcheck_armed) {
+        rtcheck_fail("post");
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+static void rtcheck_fill_inputs(double* inputs, long vector_size, long vector)
+{
+    // Sweeps through the shape and smoothing regions, with frequencies past
+    // both ends of the clamped range
+    for (long i = 0; i < vector_size; i++) {
+        double t = (double)((vector * vector_size + i) % 997) / 996.0;
+        inputs[i] = -50.0 + 40000.0 * t;
+        inputs[RTCHECK_MAX_VECTOR + i] = t;
+        inputs[2 * RTCHECK_MAX_VECTOR + i] = 1.0 - t;
+        inputs[3 * RTCHECK_MAX_VECTOR + i] = t;
+        inputs[4 * RTCHECK_MAX_VECTOR + i] = 0.5 * t;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+static void rtcheck_messages(void* x, const t_rtcheck_scenario* scenario, long vector, long instance)
+{
+    if (scenario->messages) {
+        long inlet = (vector + instance) % RTCHECK_INLETS;
+        double value = (inlet == 0) ? 0.5 + (double)(vector % 40) * 30.0 : (double)(vector % 13) / 10.0;
+        maxshim_float(x, inlet, value);         // Some land outside their inlet's range
+        if (vector % 7 == 0) {
+            maxshim_bang(x, 0);
+        }
+        if (vector % 50 == 0) {
+            maxshim_attr_setfloat(x, "freqscale", (vector % 100) ? 0.5 : 1.0);
+        }
+    }
+    if (scenario->flood) {
+        for (int i = 0; i < 40; i++) {
+            maxshim_float(x, i % RTCHECK_INLETS, (double)i / 40.0);
+        }
+    }
+    if (scenario->mute && vector % 64 == 0) {
+        ((t_pxobject*)x)->z_disabled = (vector / 64) % 2;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+static void rtcheck_run(const t_rtcheck_scenario* scenario)
+{
+    void* objects[RTCHECK_INSTANCES];
+    t_maxshim_dsp* dsps[RTCHECK_INSTANCES];
+    double inputs[RTCHECK_INLETS * RTCHECK_MAX_VECTOR];
+    double output[RTCHECK_MAX_VECTOR];
+    double* ins[RTCHECK_INLETS];
+    double* outs[1] = { output };
+    short count[RTCHECK_INLETS + 1];
+    double sample_rate = 48000.0;
+    double vector_ms = 1000.0 * (double)scenario->vector_size / sample_rate;
+    double now = maxshim_gettime();
+    t_atom args[2];
+
+    rtcheck_scenario = scenario->name;
+    for (int i = 0; i < RTCHECK_INLETS; i++) {
+        ins[i] = inputs + i * RTCHECK_MAX_VECTOR;
+        count[i] = scenario->signal_inputs ? 1 : 0;
+    }
+    count[RTCHECK_INLETS] = 1;
+
+    for (long i = 0; i < RTCHECK_INSTANCES; i++) {
+        objects[i] = maxshim_new("tide~", 0, NULL);
+        if (!objects[i]) {
+            fprintf(stderr, "tide_rtcheck: could not create tide~\n");
+            exit(2);
+        }
+        maxshim_float(objects[i], 1, (double)i / (RTCHECK_INSTANCES - 1));      // Every shape region
+        maxshim_float(objects[i], 3, (double)(RTCHECK_INSTANCES - 1 - i) / (RTCHECK_INSTANCES - 1));  // Every smoothing region
+        dsps[i] = maxshim_dsp_new(objects[i], count, sample_rate, scenario->vector_size);
+    }
+
+    // Stats and trace recording, in builds that have them
+    atom_setsym(&args[0], gensym("clear"));
+    maxshim_message(objects[0], 0, "stats", 1, args);
+    atom_setsym(&args[0], gensym("start"));
+    int tracing = maxshim_message(objects[0], 0, "trace", 1, args) == MAX_ERR_NONE;
+
+    for (long v = 0; v < RTCHECK_VECTORS; v++) {
+        for (long i = 0; i < RTCHECK_INSTANCES; i++) {
+            rtcheck_messages(objects[i], scenario, v, i);
+        }
+        rtcheck_fill_inputs(inputs, scenario->vector_size, v);
+        if (v % scenario->io_vectors == 0) {
+            maxshim_settime(now);
+        }
+
+        for (long i = 0; i < RTCHECK_INSTANCES; i++) {
+            rtcheck_armed = 1;
+            maxshim_dsp_tick(dsps[i], ins, outs, scenario->vector_size);
+            rtcheck_armed = 0;
+        }
+
+        now += vector_ms;
+        if (scenario->gaps && v % 100 == 99) {
+            now += 250.0;                       // Perform not called for a while
+        }
+    }
+
+    if (tracing) {
+        atom_setsym(&args[0], gensym("stop"));
+        atom_setsym(&args[1], gensym("tide_rtcheck_trace.json"));
+        maxshim_message(objects[0], 0, "trace", 2, args);
+    }
+    for (long i = 0; i < RTCHECK_INSTANCES; i++) {
+        maxshim_dsp_free(dsps[i]);
+        maxshim_free(objects[i]);
+    }
+    printf("ok  %s\n", scenario->name);
+}
+
+//----------------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    // backtrace loads its unwinder on first use, which allocates
+    void* frames[4];
+    backtrace(frames, 4);
+
+    // A checker that is not interposing would pass everything
+    void* (*volatile allocate)(size_t) = malloc;
+    long seen = rtcheck_calls_seen;
+    free(allocate(16));
+    if (rtcheck_calls_seen == seen) {
+        fprintf(stderr, "tide_rtcheck: allocator interposition is not active\n");
+        return 2;
+    }
+
+    maxshim_set_post_hook(rtcheck_post, NULL);
+    ext_main(NULL);
+
+    int scenarios = (int)(sizeof(rtcheck_scenarios) / sizeof(rtcheck_scenarios[0]));
+    for (int i = 0; i < scenarios; i++) {
+        rtcheck_run(&rtcheck_scenarios[i]);
+    }
+
+    maxshim_quit();     // Waits for the trace writer
+    remove("tide_rtcheck_trace.json");
+    printf("tide_rtcheck: perform made no allocation, lock or system call in %d scenarios\n", scenarios);
+    return 0;
+}
@@ -0,0 +1,161 @@
+/**
+ * tide_vector: per-call cost of tide~'s perform routines at small vector sizes
+ *
+ * tides_vector times the core calls alone; this times what Max actually runs.
+ * One tide~ object is loaded through the Max API stand-in (maxshim), its DSP
+ * is compiled with dsp64 and its perform routine is ticked at vector sizes 1,
+ * 4, 16 and 64, with the scheduler clock advanced every vector. Both routines
+ * are measured, chosen by the maximum vector size passed to dsp64:
+ *
+ *   small    tide_perform64_small (maximum vector size 16)
+ *   general  tide_perform64 (maximum vector size 64)
+ *
+ * Max never runs the small routine at 64 samples; that row shows what its
+ * lighter per-call work is worth at that size. Inputs are float messages
+ * (no signal inlets connected) or, with "signal", all five inlets as signals.
+ *
+ * Each figure is the fastest of several repetitions. With --baseline, every
+ * repetition's ns/sample is written to a baseline file (tides_baseline.h).
+ *
+ * Usage: tide_vector [samples_per_run] [float|signal] [--baseline file]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "maxshim.h"
+#include "tides_baseline.h"
+
+namespace {
+
+const double kSampleRate = 48000.0;
+const int kRepetitions = 31;
+const int kInlets = 5;
+
+enum Routine { kSmall, kGeneral };
+
+// Maximum vector size passed to dsp64 for each routine: tide~ takes the small
+// routine up to 16 samples (TIDE_SMALL_VECTOR) and the general one above
+const long kMaxVectorSize[] = { 16, 64 };
+
+// Drops the console output of tide~
+void QuietPost(const char*, void*) { }
+
+// Signal inputs, laid out like tide~'s inlets
+struct Inputs {
+    std::vector<double> frequency;
+    std::vector<double> shape;
+    std::vector<double> slope;
+    std::vector<double> smooth;
+    std::vector<double> phase;
+
+    explicit Inputs(size_t size)
+        : frequency(size), shape(size, 0.3), slope(size, 0.4), smooth(size, 0.2), phase(size, 0.0) {
+        for (size_t i = 0; i < size; i++) {
+            frequency[i] = 2.0 + 0.1 * (double)(i % 7);  // Hz
+        }
+    }
+};
+
+// Fastest time per perform call over kRepetitions runs, in nanoseconds; every
+// repetition's time per call goes to times. Returns a negative time if the
+// object cannot be created.
+double TimeCalls(Routine routine, bool signal_inputs, size_t size, long calls, std::vector<double>* times) {
+    void* x = maxshim_new("tide~", 0, NULL);
+    if (!x) {
+        return -1.0;
+    }
+    maxshim_float(x, 0, 2.0);
+    maxshim_float(x, 1, 0.3);
+    maxshim_float(x, 2, 0.4);
+    maxshim_float(x, 3, 0.2);
+
+    short count[kInlets + 1];
+    for (int i = 0; i < kInlets; i++) {
+        count[i] = signal_inputs ? 1 : 0;
+    }
+    count[kInlets] = 1;  // Outlet connected
+    t_maxshim_dsp* dsp = maxshim_dsp_new(x, count, kSampleRate, kMaxVectorSize[routine]);
+
+    Inputs in(size);
+    std::vector<double> out(size);
+    double* ins[kInlets] = { in.frequency.data(), in.shape.data(), in.slope.data(), in.smooth.data(), in.phase.data() };
+    double* outs[1] = { out.data() };
+    double vector_ms = 1000.0 * (double)size / kSampleRate;
+    double now = maxshim_gettime();
+    double best = 0.0;
+
+    // Warm up caches and branch predictors, and let the event clock anchor
+    for (long c = 0; c < calls; c++) {
+        maxshim_settime(now += vector_ms);
+        maxshim_dsp_tick(dsp, ins, outs, (long)size);
+    }
+
+    for (int r = 0; r < kRepetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        for (long c = 0; c < calls; c++) {
+            maxshim_settime(now += vector_ms);
+            maxshim_dsp_tick(dsp, ins, outs, (long)size);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count() / calls;
+        times->push_back(ns);
+        if (r == 0 || ns < best) {
+            best = ns;
+        }
+    }
+
+    maxshim_dsp_free(dsp);
+    maxshim_free(x);
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    tides_baseline::Baseline baseline("tide_vector", &argc, argv);
+    long samples = argc > 1 ? atol(argv[1]) : 100000;
+    bool signal_inputs = argc > 2 && strcmp(argv[2], "signal") == 0;
+
+    if (samples < 1 || (argc > 2 && !signal_inputs && strcmp(argv[2], "float") != 0)) {
+        fprintf(stderr, "usage: tide_vector [samples_per_run] [float|signal] [--baseline file]\n");
+        return 2;
+    }
+
+    maxshim_set_post_hook(QuietPost, NULL);
+    ext_main(NULL);
+
+    const size_t sizes[] = { 1, 4, 16, 64 };
+    const char* names[] = { "small", "general" };
+
+    printf("tide_vector: %ld samples per run, %s inputs, best of %d runs\n",
+           samples, signal_inputs ? "signal" : "float", kRepetitions);
+    printf("%10s %8s %12s %12s\n", "routine", "vs", "ns/call", "ns/sample");
+
+    for (int routine = kSmall; routine <= kGeneral; routine++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            long calls = std::max(1L, samples / (long)sizes[s]);
+            std::vector<double> times;
+            double ns = TimeCalls((Routine)routine, signal_inputs, sizes[s], calls, &times);
+            if (ns < 0.0) {
+                fprintf(stderr, "tide_vector: could not create tide~\n");
+                return 1;
+            }
+            printf("%10s %8zu %12.2f %12.2f\n", names[routine], sizes[s], ns, ns / sizes[s]);
+
+            std::string config = std::string(names[routine]) + "/" + std::to_string(sizes[s])
+                               + (signal_inputs ? "/signal" : "/float");
+            for (size_t t = 0; t < times.size(); t++) {
+                baseline.Add(config, "ns_per_sample", times[t] / sizes[s]);
+            }
+        }
+    }
+
+    maxshim_quit();
+    return baseline.Write() ? 0 : 1;
+}
@@ -0,0 +1,250 @@
+/**
+ * tides_bank: memory footprint and throughput of large generator banks
+ *
+ * Modulation fields run tens or hundreds of thousands of looping generators,
+ * where each block streams every generator's state through the caches. This
+ * reports the bytes each layout keeps per generator (hot: touched by every
+ * loop-mode sample; cold: the rest), then renders banks of increasing size
+ * with constant random parameters through each layout and reports
+ * nanoseconds per generator-sample (median and best of several runs):
+ *
+ *   block    heap generators (64-byte slots), tides_render_block each
+ *   batch    heap generators, tides_render_batch over parameter arrays
+ *   bank     tides_bank: 32-byte records, 64-bit phase, quantized parameters
+ *
+ * Output goes to a small reused buffer, so the figures show state traffic
+ * rather than output traffic. Smaller blocks make state traffic a larger part
+ * of the cost. With --baseline, every run's ns per generator-sample is written
+ * to a baseline file (tides_baseline.h).
+ *
+ * Usage: tides_bank [block_size] [max_generators] [--baseline file]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+#include "tides_baseline.h"
+#include "tides_wrapper.h"
+
+namespace {
+
+const double kSampleRate = 48000.0;
+const size_t kChunk = 64;                       // Generators per render call
+const double kSamplesPerRun = 8e6;              // Generator-samples
+const int kRuns = 7;
+const size_t kParams = 5;                       // Floats per generator for the batch layout
+
+enum Kernel { kBlock, kBatch, kBank, kKernels };
+const char* const kKernelNames[kKernels] = { "block", "batch", "bank" };
+
+struct Params {
+    float frequency;
+    float pw;
+    float shape;
+    float smoothness;
+    float shift;
+};
+
+// LFO rates and a spread over the shape and smooth regions
+std::vector<Params> RandomParams(size_t count) {
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Params> params(count);
+    for (size_t i = 0; i < count; i++) {
+        params[i].frequency = (float)((0.05 + 20.0 * unit(rng) * unit(rng)) / kSampleRate);
+        params[i].pw = unit(rng);
+        params[i].shape = unit(rng);
+        params[i].smoothness = unit(rng);
+        params[i].shift = unit(rng);
+    }
+    return params;
+}
+
+// One bank of count generators in each layout
+class Bank {
+public:
+    Bank(const std::vector<Params>& params, size_t count)
+        : generators_(count), batch_params_(count * kParams), bank_(tides_bank_create(count)) {
+        for (size_t i = 0; i < count; i++) {
+            const Params& p = params[i];
+            generators_[i] = tides_create();
+            float* b = &batch_params_[i * kParams];
+            b[0] = p.frequency;
+            b[1] = p.pw;
+            b[2] = p.shape;
+            b[3] = p.smoothness;
+            b[4] = p.shift;
+            tides_bank_set(bank_, i, p.frequency, p.pw, p.shape, p.smoothness, p.shift);
+        }
+    }
+
+    ~Bank() {
+        for (size_t i = 0; i < generators_.size(); i++) {
+            tides_destroy(generators_[i]);
+        }
+        tides_bank_destroy(bank_);
+    }
+
+    bool valid() const {
+        if (!bank_) {
+            return false;
+        }
+        for (size_t i = 0; i < generators_.size(); i++) {
+            if (!generators_[i]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Renders one block of every generator, kChunk at a time into out
+    void RenderBlock(Kernel kernel, double* out, size_t size) {
+        size_t count = generators_.size();
+        for (size_t first = 0; first < count; first += kChunk) {
+            size_t n = std::min(kChunk, count - first);
+            switch (kernel) {
+                case kBlock:
+                    for (size_t i = 0; i < n; i++) {
+                        const float* b = &batch_params_[(first + i) * kParams];
+                        tides_render_block(generators_[first + i], 1, 1, 1, b[0], b[1], b[2], b[3], b[4],
+                                           0, out + i * size, size);
+                    }
+                    break;
+                case kBatch: {
+                    const float* b = &batch_params_[first * kParams];
+                    tides_render_batch(&generators_[first], n, 1, 1, 1,
+                                       b, b + 1, b + 2, b + 3, b + 4, kParams, out, size, size);
+                    break;
+                }
+                default:
+                    tides_bank_render(bank_, first, n, out, size, size);
+                    break;
+            }
+        }
+    }
+
+private:
+    std::vector<void*> generators_;
+    std::vector<float> batch_params_;
+    tides_bank* bank_;
+};
+
+// Resident bytes per generator of each layout, as the renders above use them
+double LayoutBytes(Kernel kernel, const tides_footprint& footprint) {
+    switch (kernel) {
+        case kBlock: return (double)footprint.generator_slot + kParams * sizeof(float);
+        case kBatch: return (double)footprint.generator_slot + kParams * sizeof(float) + sizeof(void*);
+        default: return (double)footprint.bank_generator_size;
+    }
+}
+
+long CacheBytes(int level) {
+#if defined(__linux__) && defined(_SC_LEVEL2_CACHE_SIZE) && defined(_SC_LEVEL3_CACHE_SIZE)
+    return sysconf(level == 2 ? _SC_LEVEL2_CACHE_SIZE : _SC_LEVEL3_CACHE_SIZE);
+#else
+    (void)level;
+    return 0;
+#endif
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    return values[values.size() / 2];
+}
+
+void PrintFootprint(const tides_footprint& footprint) {
+    printf("generator object: %zu bytes (%zu hot, %zu cold) in a %zu-byte slot\n",
+           footprint.generator_size, footprint.generator_hot,
+           footprint.generator_size - footprint.generator_hot, footprint.generator_slot);
+    printf("bank generator:   %zu bytes, all hot\n\n", footprint.bank_generator_size);
+
+    long caches[2] = { CacheBytes(2), CacheBytes(3) };
+    printf("%-8s %14s %14s %14s\n", "layout", "bytes/gen", "gens/L2", "gens/L3");
+    for (int k = 0; k < kKernels; k++) {
+        double bytes = LayoutBytes((Kernel)k, footprint);
+        printf("%-8s %14.0f", kKernelNames[k], bytes);
+        for (int c = 0; c < 2; c++) {
+            if (caches[c] > 0) {
+                printf(" %14.0f", (double)caches[c] / bytes);
+            } else {
+                printf(" %14s", "-");
+            }
+        }
+        printf("\n");
+    }
+    printf("(block and batch count the 5 caller-held parameters, batch also its handle;\n"
+           " a tide~ object adds its own heap, see tide_load)\n\n");
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    tides_baseline::Baseline baseline("tides_bank", &argc, argv);
+    long block_size = argc > 1 ? atol(argv[1]) : 64;
+    long max_generators = argc > 2 ? atol(argv[2]) : 1 << 20;
+
+    if (block_size < 1 || max_generators < 1) {
+        fprintf(stderr, "usage: tides_bank [block_size] [max_generators] [--baseline file]\n");
+        return 2;
+    }
+    size_t size = (size_t)block_size;
+
+    tides_footprint footprint;
+    tides_get_footprint(&footprint);
+    printf("tides_bank: block size %zu, %d runs (median / best)\n\n", size, kRuns);
+    PrintFootprint(footprint);
+
+    std::vector<Params> params = RandomParams((size_t)max_generators);
+    std::vector<double> out(kChunk * size);
+
+    printf("%-8s %10s %10s %14s %14s %10s\n",
+           "layout", "gens", "state_MB", "ns/gs_median", "ns/gs_best", "vs_batch");
+    for (size_t count = 1024; count <= (size_t)max_generators; count *= 4) {
+        Bank bank(params, count);
+        if (!bank.valid()) {
+            fprintf(stderr, "tides_bank: out of memory at %zu generators\n", count);
+            return 1;
+        }
+        long blocks = std::max(1L, (long)(kSamplesPerRun / ((double)count * (double)size)));
+        double batch_median = 0.0;
+
+        for (int k = 0; k < kKernels; k++) {
+            Kernel kernel = (Kernel)k;
+            bank.RenderBlock(kernel, out.data(), size);   // Warm-up
+
+            std::vector<double> ns;
+            for (int r = 0; r < kRuns; r++) {
+                std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+                for (long b = 0; b < blocks; b++) {
+                    bank.RenderBlock(kernel, out.data(), size);
+                }
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                ns.push_back(seconds * 1e9 / ((double)blocks * (double)count * (double)size));
+                baseline.Add(std::string(kKernelNames[k]) + "/" + std::to_string(count), "ns_per_sample", ns.back());
+            }
+
+            double median = Median(ns);
+            if (kernel == kBatch) {
+                batch_median = median;
+            }
+            printf("%-8s %10zu %10.2f %14.3f %14.3f", kKernelNames[k], count,
+                   LayoutBytes(kernel, footprint) * (double)count / (1024.0 * 1024.0),
+                   median, *std::min_element(ns.begin(), ns.end()));
+            if (kernel == kBlock) {
+                printf(" %10s\n", "");
+            } else {
+                printf(" %9.2fx\n", batch_median / median);
+            }
+        }
+    }
+    return baseline.Write() ? 0 : 1;
+}
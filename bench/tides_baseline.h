@@ -0,0 +1,149 @@
+/**
+ * Versioned JSON baseline files for the benchmark executables
+ *
+ * Benchmarks that take "--baseline <file>" record every repetition they time
+ * (not just the best) under a configuration name, and write them as:
+ *
+ *   {
+ *     "format": 1,
+ *     "benchmark": "tides_vector",
+ *     "args": "100000",
+ *     "compiler": "...",
+ *     "created": "2026-01-01T00:00:00Z",
+ *     "results": [
+ *       { "config": "block/1", "unit": "ns_per_sample", "samples": [ ... ] },
+ *       ...
+ *     ]
+ *   }
+ *
+ * Lower is better for every unit. tides_compare merges the samples of
+ * several such files (repeated runs) and tests one set against another.
+ * Bump kBaselineFormat when the layout changes incompatibly.
+ */
+
+#ifndef TIDES_BASELINE_H
+#define TIDES_BASELINE_H
+
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+namespace tides_baseline {
+
+const int kBaselineFormat = 1;
+
+class Baseline {
+public:
+    // Removes "--baseline <file>" from argv, so the benchmark's own arguments
+    // parse as before; inactive when the option is absent
+    Baseline(const char* benchmark, int* argc, char** argv) : benchmark_(benchmark) {
+        int kept = 1;
+        for (int i = 1; i < *argc; i++) {
+            if (strcmp(argv[i], "--baseline") == 0 && i + 1 < *argc) {
+                path_ = argv[++i];
+            } else {
+                if (!args_.empty()) {
+                    args_ += " ";
+                }
+                args_ += argv[i];
+                argv[kept++] = argv[i];
+            }
+        }
+        *argc = kept;
+        argv[kept] = NULL;
+    }
+
+    bool enabled() const {
+        return !path_.empty();
+    }
+
+    // Appends one timed repetition of config
+    void Add(const std::string& config, const char* unit, double value) {
+        if (!enabled()) {
+            return;
+        }
+        for (size_t r = 0; r < results_.size(); r++) {
+            if (results_[r].config == config) {
+                results_[r].samples.push_back(value);
+                return;
+            }
+        }
+        Result result;
+        result.config = config;
+        result.unit = unit;
+        result.samples.push_back(value);
+        results_.push_back(result);
+    }
+
+    // Writes the file when enabled; false (with a message) if it cannot be written
+    bool Write() const {
+        if (!enabled()) {
+            return true;
+        }
+        FILE* file = fopen(path_.c_str(), "w");
+        if (!file) {
+            fprintf(stderr, "%s: cannot write %s\n", benchmark_.c_str(), path_.c_str());
+            return false;
+        }
+
+        char created[32];
+        time_t now = time(NULL);
+        strftime(created, sizeof(created), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+#if defined(__clang__)
+        const char* compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+        const char* compiler = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        const char* compiler = "msvc";
+#else
+        const char* compiler = "unknown";
+#endif
+
+        fprintf(file, "{\n  \"format\": %d,\n  \"benchmark\": \"%s\",\n  \"args\": \"%s\",\n"
+                      "  \"compiler\": \"%s\",\n  \"created\": \"%s\",\n  \"results\": [\n",
+                kBaselineFormat, Escape(benchmark_).c_str(), Escape(args_).c_str(),
+                Escape(compiler).c_str(), created);
+        for (size_t r = 0; r < results_.size(); r++) {
+            const Result& result = results_[r];
+            fprintf(file, "    { \"config\": \"%s\", \"unit\": \"%s\", \"samples\": [",
+                    Escape(result.config).c_str(), Escape(result.unit).c_str());
+            for (size_t s = 0; s < result.samples.size(); s++) {
+                fprintf(file, "%s%.6g", s ? ", " : " ", result.samples[s]);
+            }
+            fprintf(file, " ] }%s\n", r + 1 < results_.size() ? "," : "");
+        }
+        fprintf(file, "  ]\n}\n");
+        fclose(file);
+        printf("wrote baseline %s\n", path_.c_str());
+        return true;
+    }
+
+private:
+    struct Result {
+        std::string config;
+        std::string unit;
+        std::vector<double> samples;
+    };
+
+    std::string benchmark_;
+    std::string path_;
+    std::string args_;
+    std::vector<Result> results_;
+
+    static std::string Escape(const std::string& text) {
+        std::string escaped;
+        for (size_t i = 0; i < text.size(); i++) {
+            if (text[i] == '"' || text[i] == '\\') {
+                escaped += '\\';
+            }
+            escaped += (unsigned char)text[i] < 0x20 ? ' ' : text[i];
+        }
+        return escaped;
+    }
+};
+
+} // namespace tides_baseline
+
+#endif // TIDES_BASELINE_H
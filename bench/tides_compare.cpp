@@ -0,0 +1,460 @@
+/**
+ * tides_compare: flags benchmark configurations that regressed against a baseline
+ *
+ * Reads baseline files written by the benchmarks' --baseline option
+ * (tides_baseline.h). The files before "--" are the stored baseline and the
+ * files after it the current runs; repeated runs of one benchmark are merged
+ * per configuration, so a benchmark that records one sample per run (such as
+ * tides_stress or tide_host) is simply run several times.
+ *
+ * For each configuration it asks whether the current samples are larger than
+ * the baseline samples scaled by (1 + threshold), with a one-sided
+ * Mann-Whitney U test: exact for small samples without ties, the normal
+ * approximation with tie correction otherwise. Configurations with p below
+ * alpha are flagged as slower, so a slowdown must be both larger than the
+ * threshold and consistent across repetitions. Each configuration is tested
+ * on its own, without correction for the number of configurations.
+ *
+ * Deterministic counts (unit count_per_sample, from tides_counts) repeat from
+ * run to run, so their medians are compared directly against the threshold.
+ * Configurations with too few samples for any result to reach alpha are
+ * reported as "few".
+ *
+ * Exits with 1 when any configuration is flagged, 2 on bad input.
+ *
+ * Usage: tides_compare [--threshold percent] [--alpha p] baseline.json ... -- current.json ...
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "tides_baseline.h"
+
+namespace {
+
+const double kDefaultThreshold = 5.0;   // Percent
+const double kDefaultAlpha = 0.01;
+const size_t kExactLimit = 20;          // Largest group tested with the exact distribution
+const char* const kCountUnit = "count_per_sample";
+
+//----------------------------------------------------------------------------------------------
+// JSON (just enough for baseline files)
+
+struct Value {
+    enum Type { kNull, kBool, kNumber, kString, kArray, kObject } type;
+    double number;
+    std::string string;
+    std::vector<Value> items;
+    std::vector<std::pair<std::string, Value> > members;
+
+    Value() : type(kNull), number(0.0) {}
+
+    const Value* Find(const char* key) const {
+        for (size_t i = 0; i < members.size(); i++) {
+            if (members[i].first == key) {
+                return &members[i].second;
+            }
+        }
+        return NULL;
+    }
+};
+
+class Parser {
+public:
+    explicit Parser(const std::string& text) : text_(text), pos_(0) {}
+
+    bool Parse(Value* value) {
+        return ParseValue(value, 0) && (SkipSpace(), pos_ == text_.size());
+    }
+
+private:
+    const std::string& text_;
+    size_t pos_;
+
+    void SkipSpace() {
+        while (pos_ < text_.size() && isspace((unsigned char)text_[pos_])) {
+            pos_++;
+        }
+    }
+
+    bool Consume(char c) {
+        SkipSpace();
+        if (pos_ < text_.size() && text_[pos_] == c) {
+            pos_++;
+            return true;
+        }
+        return false;
+    }
+
+    bool ParseString(std::string* out) {
+        if (!Consume('"')) {
+            return false;
+        }
+        out->clear();
+        while (pos_ < text_.size() && text_[pos_] != '"') {
+            char c = text_[pos_++];
+            if (c == '\\' && pos_ < text_.size()) {
+                char e = text_[pos_++];
+                switch (e) {
+                    case 'n': c = '\n'; break;
+                    case 't': c = '\t'; break;
+                    case 'u': c = '?'; pos_ = std::min(text_.size(), pos_ + 4); break;
+                    default: c = e; break;   // \" \\ \/
+                }
+            }
+            *out += c;
+        }
+        return Consume('"');
+    }
+
+    bool ParseValue(Value* value, int depth) {
+        SkipSpace();
+        if (pos_ >= text_.size() || depth > 16) {
+            return false;
+        }
+        char c = text_[pos_];
+        if (c == '{') {
+            value->type = Value::kObject;
+            pos_++;
+            if (Consume('}')) {
+                return true;
+            }
+            do {
+                std::pair<std::string, Value> member;
+                if (!ParseString(&member.first) || !Consume(':') || !ParseValue(&member.second, depth + 1)) {
+                    return false;
+                }
+                value->members.push_back(member);
+            } while (Consume(','));
+            return Consume('}');
+        }
+        if (c == '[') {
+            value->type = Value::kArray;
+            pos_++;
+            if (Consume(']')) {
+                return true;
+            }
+            do {
+                value->items.push_back(Value());
+                if (!ParseValue(&value->items.back(), depth + 1)) {
+                    return false;
+                }
+            } while (Consume(','));
+            return Consume(']');
+        }
+        if (c == '"') {
+            value->type = Value::kString;
+            return ParseString(&value->string);
+        }
+        const char* words[] = { "null", "true", "false" };
+        for (int w = 0; w < 3; w++) {
+            size_t length = strlen(words[w]);
+            if (text_.compare(pos_, length, words[w]) == 0) {
+                value->type = w == 0 ? Value::kNull : Value::kBool;
+                value->number = w == 1 ? 1.0 : 0.0;
+                pos_ += length;
+                return true;
+            }
+        }
+        char* end = NULL;
+        value->type = Value::kNumber;
+        value->number = strtod(text_.c_str() + pos_, &end);
+        if (end == text_.c_str() + pos_) {
+            return false;
+        }
+        pos_ = (size_t)(end - text_.c_str());
+        return true;
+    }
+};
+
+//----------------------------------------------------------------------------------------------
+// Samples
+
+struct Series {
+    std::string benchmark;
+    std::string config;
+    std::string unit;
+    std::string args;
+    std::vector<double> samples;
+};
+
+Series* FindSeries(std::vector<Series>* all, const std::string& benchmark, const std::string& config) {
+    for (size_t i = 0; i < all->size(); i++) {
+        if ((*all)[i].benchmark == benchmark && (*all)[i].config == config) {
+            return &(*all)[i];
+        }
+    }
+    return NULL;
+}
+
+// Merges one baseline file into all; false (with a message) when it cannot be used
+bool Load(const char* path, std::vector<Series>* all) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "tides_compare: cannot read %s\n", path);
+        return false;
+    }
+    std::string text;
+    char buffer[4096];
+    for (size_t n; (n = fread(buffer, 1, sizeof(buffer), file)) > 0; ) {
+        text.append(buffer, n);
+    }
+    fclose(file);
+
+    Value root;
+    if (!Parser(text).Parse(&root) || root.type != Value::kObject) {
+        fprintf(stderr, "tides_compare: %s is not valid JSON\n", path);
+        return false;
+    }
+    const Value* format = root.Find("format");
+    const Value* benchmark = root.Find("benchmark");
+    const Value* args = root.Find("args");
+    const Value* results = root.Find("results");
+    if (!format || format->type != Value::kNumber || !benchmark || benchmark->type != Value::kString
+        || !results || results->type != Value::kArray) {
+        fprintf(stderr, "tides_compare: %s is not a baseline file\n", path);
+        return false;
+    }
+    if ((int)format->number != tides_baseline::kBaselineFormat) {
+        fprintf(stderr, "tides_compare: %s has format %d, this build reads format %d\n",
+                path, (int)format->number, tides_baseline::kBaselineFormat);
+        return false;
+    }
+    std::string run_args = args && args->type == Value::kString ? args->string : "";
+
+    for (size_t r = 0; r < results->items.size(); r++) {
+        const Value& result = results->items[r];
+        const Value* config = result.Find("config");
+        const Value* unit = result.Find("unit");
+        const Value* samples = result.Find("samples");
+        if (!config || config->type != Value::kString || !samples || samples->type != Value::kArray) {
+            fprintf(stderr, "tides_compare: %s has a malformed result\n", path);
+            return false;
+        }
+
+        Series* series = FindSeries(all, benchmark->string, config->string);
+        if (!series) {
+            Series added;
+            added.benchmark = benchmark->string;
+            added.config = config->string;
+            added.unit = unit && unit->type == Value::kString ? unit->string : "";
+            added.args = run_args;
+            all->push_back(added);
+            series = &all->back();
+        } else if (series->args != run_args) {
+            fprintf(stderr, "tides_compare: warning: %s ran %s with \"%s\", other runs with \"%s\"\n",
+                    path, benchmark->string.c_str(), run_args.c_str(), series->args.c_str());
+            series->args = run_args;    // Warn once per change
+        }
+        for (size_t s = 0; s < samples->items.size(); s++) {
+            if (samples->items[s].type == Value::kNumber) {
+                series->samples.push_back(samples->items[s].number);
+            }
+        }
+    }
+    return true;
+}
+
+double Median(std::vector<double> values) {
+    std::sort(values.begin(), values.end());
+    size_t n = values.size();
+    return n % 2 ? values[n / 2] : 0.5 * (values[n / 2 - 1] + values[n / 2]);
+}
+
+//----------------------------------------------------------------------------------------------
+// Mann-Whitney U
+
+// ln of the number of orderings of m + n items, m of one kind
+double LogChoose(size_t m, size_t n) {
+    return std::lgamma((double)(m + n) + 1.0) - std::lgamma((double)m + 1.0) - std::lgamma((double)n + 1.0);
+}
+
+// P(U >= u) under the null for groups of m and n without ties: counts the
+// orderings by U (U grows by n when the largest item is from the first group)
+double ExactUpperTail(size_t m, size_t n, double u) {
+    size_t max_u = m * n;
+    // counts[i][j][k]: orderings of i and j items with U = k, kept for the current i only
+    std::vector<std::vector<double> > previous(n + 1), current(n + 1);
+    for (size_t j = 0; j <= n; j++) {
+        previous[j].assign(max_u + 1, 0.0);
+        previous[j][0] = 1.0;           // No first-group items: U = 0
+    }
+    for (size_t i = 1; i <= m; i++) {
+        for (size_t j = 0; j <= n; j++) {
+            current[j].assign(max_u + 1, 0.0);
+            for (size_t k = 0; k <= i * j; k++) {
+                double count = k >= j ? previous[j][k - j] : 0.0;
+                if (j > 0) {
+                    count += current[j - 1][k];
+                }
+                current[j][k] = count;
+            }
+        }
+        previous.swap(current);
+    }
+
+    double tail = 0.0;
+    for (size_t k = (size_t)std::ceil(u); k <= max_u; k++) {
+        tail += previous[n][k];
+    }
+    return tail * std::exp(-LogChoose(m, n));
+}
+
+// One-sided p-value that a tends to be larger than b
+double MannWhitneyGreater(const std::vector<double>& a, const std::vector<double>& b) {
+    size_t m = a.size();
+    size_t n = b.size();
+
+    // U from mid-ranks of the pooled samples; tie groups kept for the variance
+    std::vector<std::pair<double, int> > pooled;
+    for (size_t i = 0; i < m; i++) {
+        pooled.push_back(std::make_pair(a[i], 0));
+    }
+    for (size_t j = 0; j < n; j++) {
+        pooled.push_back(std::make_pair(b[j], 1));
+    }
+    std::sort(pooled.begin(), pooled.end());
+
+    double rank_sum = 0.0;
+    double tie_term = 0.0;
+    for (size_t i = 0; i < pooled.size(); ) {
+        size_t end = i;
+        while (end < pooled.size() && pooled[end].first == pooled[i].first) {
+            end++;
+        }
+        double rank = 0.5 * (double)(i + 1 + end);
+        for (size_t k = i; k < end; k++) {
+            if (pooled[k].second == 0) {
+                rank_sum += rank;
+            }
+        }
+        double t = (double)(end - i);
+        tie_term += t * t * t - t;
+        i = end;
+    }
+    double u = rank_sum - 0.5 * (double)m * (double)(m + 1);
+
+    if (tie_term == 0.0 && m <= kExactLimit && n <= kExactLimit) {
+        return ExactUpperTail(m, n, u);
+    }
+
+    double total = (double)(m + n);
+    double variance = (double)m * (double)n / 12.0 * ((total + 1.0) - tie_term / (total * (total - 1.0)));
+    if (variance <= 0.0) {
+        return 1.0;
+    }
+    double z = (u - 0.5 * (double)m * (double)n - 0.5) / std::sqrt(variance);
+    return 0.5 * std::erfc(z / std::sqrt(2.0));
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double threshold = kDefaultThreshold;
+    double alpha = kDefaultAlpha;
+    std::vector<const char*> base_paths, current_paths;
+    bool after_separator = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threshold") == 0 && i + 1 < argc) {
+            threshold = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--alpha") == 0 && i + 1 < argc) {
+            alpha = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--") == 0) {
+            after_separator = true;
+        } else {
+            (after_separator ? current_paths : base_paths).push_back(argv[i]);
+        }
+    }
+    if (!after_separator && base_paths.size() == 2) {
+        current_paths.push_back(base_paths[1]);     // tides_compare baseline.json current.json
+        base_paths.pop_back();
+    }
+    if (base_paths.empty() || current_paths.empty() || !(threshold >= 0.0) || !(alpha > 0.0 && alpha < 1.0)) {
+        fprintf(stderr, "usage: tides_compare [--threshold percent] [--alpha p] baseline.json ... -- current.json ...\n");
+        return 2;
+    }
+
+    std::vector<Series> base, current;
+    for (size_t i = 0; i < base_paths.size(); i++) {
+        if (!Load(base_paths[i], &base)) {
+            return 2;
+        }
+    }
+    for (size_t i = 0; i < current_paths.size(); i++) {
+        if (!Load(current_paths[i], &current)) {
+            return 2;
+        }
+    }
+
+    printf("tides_compare: %zu baseline and %zu current file(s), flagging slowdowns over %.3g%% at p < %.3g\n",
+           base_paths.size(), current_paths.size(), threshold, alpha);
+    printf("%-14s %-30s %6s %6s %12s %12s %9s %10s  %s\n",
+           "benchmark", "config", "n_base", "n_cur", "base_median", "cur_median", "change", "p", "result");
+
+    double scale = 1.0 + threshold / 100.0;
+    int slower = 0, few = 0;
+    for (size_t i = 0; i < base.size(); i++) {
+        const Series& b = base[i];
+        const Series* c = FindSeries(&current, b.benchmark, b.config);
+        if (!c || c->samples.empty() || b.samples.empty()) {
+            printf("%-14s %-30s %6zu %6zu %12s %12s %9s %10s  missing\n", b.benchmark.c_str(), b.config.c_str(),
+                   b.samples.size(), c ? c->samples.size() : (size_t)0, "-", "-", "-", "-");
+            continue;
+        }
+        if (c->args != b.args) {
+            fprintf(stderr, "tides_compare: warning: %s baseline ran with \"%s\", current with \"%s\"\n",
+                    b.benchmark.c_str(), b.args.c_str(), c->args.c_str());
+        }
+
+        double base_median = Median(b.samples);
+        double current_median = Median(c->samples);
+        double change = base_median != 0.0 ? 100.0 * (current_median / base_median - 1.0) : 0.0;
+
+        std::vector<double> scaled(b.samples);
+        for (size_t s = 0; s < scaled.size(); s++) {
+            scaled[s] *= scale;
+        }
+
+        char p_text[32] = "-";
+        const char* result;
+        if (b.unit == kCountUnit) {
+            result = current_median > base_median * scale ? "SLOWER" : "ok";
+        } else if (-LogChoose(b.samples.size(), c->samples.size()) > std::log(alpha)) {
+            result = "few";             // Even the most extreme ordering could not reach alpha
+        } else {
+            double p = MannWhitneyGreater(c->samples, scaled);
+            snprintf(p_text, sizeof(p_text), "%.2g", p);
+            result = p < alpha ? "SLOWER" : "ok";
+        }
+        slower += strcmp(result, "SLOWER") == 0 ? 1 : 0;
+        few += strcmp(result, "few") == 0 ? 1 : 0;
+
+        printf("%-14s %-30s %6zu %6zu %12.4g %12.4g %+8.2f%% %10s  %s\n", b.benchmark.c_str(), b.config.c_str(),
+               b.samples.size(), c->samples.size(), base_median, current_median, change, p_text, result);
+    }
+    for (size_t i = 0; i < current.size(); i++) {
+        if (!FindSeries(&base, current[i].benchmark, current[i].config)) {
+            printf("%-14s %-30s %6s %6zu %12s %12.4g %9s %10s  new\n", current[i].benchmark.c_str(),
+                   current[i].config.c_str(), "-", current[i].samples.size(), "-",
+                   Median(current[i].samples), "-", "-");
+        }
+    }
+
+    if (few) {
+        printf("tides_compare: %d configuration(s) have too few samples to test at p < %.3g; repeat the runs\n",
+               few, alpha);
+    }
+    if (slower) {
+        printf("tides_compare: %d configuration(s) slower than the baseline\n", slower);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,470 @@
+/**
+ * tides_counts: deterministic per-sample instruction and cache-miss counts
+ *
+ * Wall-clock figures on shared machines are too noisy to catch small
+ * regressions in Render. This counts retired user-space instructions and
+ * cache misses per rendered sample for every kernel and configuration, which
+ * repeat exactly from run to run on the same build and machine:
+ *
+ *   instructions      retired instructions
+ *   l1d_read_misses   L1 data cache read misses
+ *   llc_misses        last-level cache misses
+ *
+ * Counts come from perf_event_open hardware counters, around the measured
+ * renders only. Where those are not available (virtual machines without a
+ * PMU, perf_event_paranoid above 2, --cachegrind), every configuration is run
+ * instead in a child process under valgrind's cachegrind, once with and once
+ * without the measured renders, and the difference of the two summaries is
+ * used. Cachegrind simulates its caches, so its miss counts are comparable
+ * with each other but not with the hardware's; "source" in the output says
+ * which was used. $VALGRIND overrides the valgrind executable.
+ *
+ * Results are written as JSON, one configuration per line in a fixed order,
+ * so two runs can be compared with diff. A counter the machine does not have
+ * is written as null. With --baseline, the counts are also written to a
+ * baseline file (tides_baseline.h) as instructions or misses per sample.
+ *
+ * Usage: tides_counts [samples] [output_json] [--cachegrind] [--baseline file]
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <spawn.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "tides_baseline.h"
+#include "tides_wrapper.h"
+
+extern char** environ;
+
+namespace {
+
+const double kSampleRate = 48000.0;
+const size_t kBlockSize = 64;
+const int kBatchLanes = 8;
+const size_t kWarmupSamples = 4096;
+const int kRepetitions = 3;             // Lowest count wins (perf only; cachegrind is exact)
+
+enum Kernel { kBlock, kSignal, kBatch, kKernels };
+const char* const kKernelNames[kKernels] = { "block", "signal", "batch" };
+
+struct Config {
+    const char* name;
+    float frequency;                    // Cycles per sample
+    float pw;
+    float shape;
+    float smoothness;
+};
+
+const Config kConfigs[] = {
+    { "linear",  440.0f / 48000.0f, 0.5f, 0.0f, 0.0f },
+    { "exp",     440.0f / 48000.0f, 0.5f, 0.3f, 0.0f },
+    { "log",     440.0f / 48000.0f, 0.5f, 0.8f, 0.0f },
+    { "filter",  440.0f / 48000.0f, 0.5f, 0.0f, 0.3f },
+    { "fold",    440.0f / 48000.0f, 0.5f, 0.0f, 0.9f },
+    { "frozen",  0.0f,              0.5f, 0.3f, 0.3f },   // Idle: block fast path
+};
+
+const size_t kConfigCount = sizeof(kConfigs) / sizeof(kConfigs[0]);
+const size_t kRuns = kKernels * kConfigCount;
+
+enum Counter { kInstructions, kL1dReadMisses, kLlcMisses, kCounters };
+const char* const kCounterNames[kCounters] = { "instructions", "l1d_read_misses", "llc_misses" };
+
+struct Counts {
+    bool valid[kCounters];
+    double value[kCounters];            // Per sample
+};
+
+//----------------------------------------------------------------------------------------------
+// Rendering
+
+class Bench {
+public:
+    Bench(Kernel kernel, const Config& config)
+        : kernel_(kernel), config_(config), generators_(kernel == kBatch ? kBatchLanes : 1),
+          out_(kBlockSize * kBatchLanes) {
+        for (size_t g = 0; g < generators_.size(); g++) {
+            generators_[g] = tides_create();
+        }
+    }
+
+    ~Bench() {
+        for (size_t g = 0; g < generators_.size(); g++) {
+            tides_destroy(generators_[g]);
+        }
+    }
+
+    // Renders samples per generator
+    void Render(size_t samples) {
+        const Config& c = config_;
+        for (size_t done = 0; done < samples; done += kBlockSize) {
+            size_t size = std::min(kBlockSize, samples - done);
+            switch (kernel_) {
+                case kBlock:
+                    tides_render_block(generators_[0], 1, 1, 1, c.frequency, c.pw, c.shape, c.smoothness, 0.0f,
+                                       0, out_.data(), size);
+                    break;
+                case kSignal:
+                    for (size_t i = 0; i < size; i++) {
+                        float sample[4];
+                        tides_render(generators_[0], 1, 1, 1, c.frequency, c.pw, c.shape, c.smoothness, 0.0f,
+                                     0, sample);
+                        out_[i] = sample[0];
+                    }
+                    break;
+                default: {
+                    float frequency[kBatchLanes], pw[kBatchLanes], shape[kBatchLanes];
+                    float smoothness[kBatchLanes], shift[kBatchLanes];
+                    for (int l = 0; l < kBatchLanes; l++) {
+                        frequency[l] = c.frequency * (1.0f + 0.01f * (float)l);
+                        pw[l] = c.pw;
+                        shape[l] = c.shape;
+                        smoothness[l] = c.smoothness;
+                        shift[l] = 0.0f;
+                    }
+                    tides_render_batch(generators_.data(), kBatchLanes, 1, 1, 1,
+                                       frequency, pw, shape, smoothness, shift, 1, out_.data(), kBlockSize, size);
+                    break;
+                }
+            }
+        }
+    }
+
+    // Generators whose samples a render produces
+    int Lanes() const {
+        return (int)generators_.size();
+    }
+
+private:
+    Kernel kernel_;
+    Config config_;
+    std::vector<void*> generators_;
+    std::vector<double> out_;
+};
+
+//----------------------------------------------------------------------------------------------
+// Hardware counters
+
+class PerfCounters {
+public:
+    PerfCounters() : leader_(-1) {
+        for (int c = 0; c < kCounters; c++) {
+            fd_[c] = -1;
+            id_[c] = 0;
+        }
+
+        // Instructions lead the group; the miss counters join it when the CPU has them
+        leader_ = Open(kInstructions, PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, -1);
+        if (leader_ < 0) {
+            return;
+        }
+        Open(kL1dReadMisses, PERF_TYPE_HW_CACHE,
+             PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+             leader_);
+        Open(kLlcMisses, PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, leader_);
+    }
+
+    ~PerfCounters() {
+        for (int c = 0; c < kCounters; c++) {
+            if (fd_[c] >= 0) {
+                close(fd_[c]);
+            }
+        }
+    }
+
+    bool Available() const {
+        return leader_ >= 0;
+    }
+
+    // Counts over one render of samples, or false when the group was not scheduled throughout
+    bool Measure(Bench* bench, size_t samples, Counts* counts) {
+        ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+        ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        bench->Render(samples);
+        ioctl(leader_, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+        // PERF_FORMAT_GROUP | TOTAL_TIME_ENABLED | TOTAL_TIME_RUNNING | ID:
+        // nr, time_enabled, time_running, then value and id per counter
+        uint64_t data[3 + 2 * kCounters];
+        if (read(leader_, data, sizeof(data)) < (ssize_t)(3 * sizeof(uint64_t))) {
+            return false;
+        }
+        if (data[2] != data[1]) {
+            return false;               // Multiplexed with other events: not exact
+        }
+
+        double per_sample = 1.0 / ((double)samples * bench->Lanes());
+        for (int c = 0; c < kCounters; c++) {
+            counts->valid[c] = false;
+            for (uint64_t i = 0; i < data[0] && fd_[c] >= 0; i++) {
+                if (data[4 + 2 * i] == id_[c]) {
+                    counts->valid[c] = true;
+                    counts->value[c] = (double)data[3 + 2 * i] * per_sample;
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    int leader_;
+    int fd_[kCounters];
+    uint64_t id_[kCounters];
+
+    int Open(Counter counter, uint32_t type, uint64_t config, int group) {
+        struct perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group < 0 ? 1 : 0;
+        attr.exclude_kernel = 1;        // User space only: allowed at perf_event_paranoid 2
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED
+                           | PERF_FORMAT_TOTAL_TIME_RUNNING | PERF_FORMAT_ID;
+
+        int fd = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+        if (fd >= 0) {
+            ioctl(fd, PERF_EVENT_IOC_ID, &id_[counter]);
+        }
+        fd_[counter] = fd;
+        return fd;
+    }
+};
+
+bool MeasurePerf(PerfCounters* perf, size_t run, size_t samples, Counts* counts) {
+    Bench bench((Kernel)(run / kConfigCount), kConfigs[run % kConfigCount]);
+    bench.Render(kWarmupSamples);
+
+    bool measured = false;
+    for (int r = 0; r < kRepetitions; r++) {
+        Counts rep;
+        if (!perf->Measure(&bench, samples, &rep)) {
+            continue;
+        }
+        if (!measured) {
+            *counts = rep;
+            measured = true;
+        }
+        for (int c = 0; c < kCounters; c++) {
+            counts->value[c] = std::min(counts->value[c], rep.value[c]);
+        }
+    }
+    return measured;
+}
+
+//----------------------------------------------------------------------------------------------
+// Cachegrind fallback
+
+// Runs this executable's single-configuration mode under cachegrind; fills
+// events with the summary line, keyed by the names on the events line
+bool RunCachegrind(size_t run, size_t samples, std::vector<std::string>* names, std::vector<double>* events) {
+    char self[4096];
+    ssize_t length = readlink("/proc/self/exe", self, sizeof(self) - 1);
+    if (length <= 0) {
+        return false;
+    }
+    self[length] = '\0';
+
+    char out_file[] = "/tmp/tides_counts_XXXXXX";
+    int fd = mkstemp(out_file);
+    if (fd < 0) {
+        return false;
+    }
+    close(fd);
+
+    const char* valgrind = getenv("VALGRIND") ? getenv("VALGRIND") : "valgrind";
+    std::string out_option = std::string("--cachegrind-out-file=") + out_file;
+    std::string run_arg = std::to_string(run);
+    std::string samples_arg = std::to_string(samples);
+    const char* argv[] = {
+        valgrind, "--tool=cachegrind", "--cache-sim=yes", out_option.c_str(),
+        self, "--single", run_arg.c_str(), samples_arg.c_str(), NULL
+    };
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_addopen(&actions, STDERR_FILENO, "/dev/null", O_WRONLY, 0);
+    pid_t pid;
+    int spawned = posix_spawnp(&pid, valgrind, &actions, NULL, const_cast<char* const*>(argv), environ);
+    posix_spawn_file_actions_destroy(&actions);
+
+    int status = 0;
+    bool ok = spawned == 0 && waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+
+    FILE* file = ok ? fopen(out_file, "r") : NULL;
+    bool found = false;
+    if (file) {
+        char line[4096];
+        names->clear();
+        while (fgets(line, sizeof(line), file)) {
+            if (strncmp(line, "events:", 7) == 0) {
+                for (char* token = strtok(line + 7, " \t\n"); token; token = strtok(NULL, " \t\n")) {
+                    names->push_back(token);
+                }
+            } else if (strncmp(line, "summary:", 8) == 0) {
+                events->clear();
+                for (char* token = strtok(line + 8, " \t\n"); token; token = strtok(NULL, " \t\n")) {
+                    events->push_back(strtod(token, NULL));
+                }
+                found = true;
+            }
+        }
+        fclose(file);
+    }
+    unlink(out_file);
+    return found && events->size() == names->size();
+}
+
+double Event(const std::vector<std::string>& names, const std::vector<double>& events, const char* name,
+             bool* present) {
+    for (size_t i = 0; i < names.size(); i++) {
+        if (names[i] == name) {
+            return events[i];
+        }
+    }
+    *present = false;
+    return 0.0;
+}
+
+bool MeasureCachegrind(size_t run, size_t samples, Counts* counts) {
+    std::vector<std::string> names, base_names;
+    std::vector<double> events, base_events;
+    if (!RunCachegrind(run, samples, &names, &events) || !RunCachegrind(run, 0, &base_names, &base_events)
+        || names != base_names) {
+        return false;
+    }
+
+    // The run without measured renders carries startup, warm-up and teardown
+    std::vector<double> delta(events.size());
+    for (size_t i = 0; i < events.size(); i++) {
+        delta[i] = events[i] - base_events[i];
+    }
+    double per_sample = 1.0 / ((double)samples * (run / kConfigCount == kBatch ? kBatchLanes : 1));
+
+    bool instructions = true, l1d = true, llc = true;
+    double ir = Event(names, delta, "Ir", &instructions);
+    double d1mr = Event(names, delta, "D1mr", &l1d);
+    double llc_total = Event(names, delta, "ILmr", &llc) + Event(names, delta, "DLmr", &llc)
+                       + Event(names, delta, "DLmw", &llc);
+
+    counts->valid[kInstructions] = instructions;
+    counts->value[kInstructions] = ir * per_sample;
+    counts->valid[kL1dReadMisses] = l1d;
+    counts->value[kL1dReadMisses] = d1mr * per_sample;
+    counts->valid[kLlcMisses] = llc;
+    counts->value[kLlcMisses] = llc_total * per_sample;
+    return true;
+}
+
+// Child side of the fallback: warm-up, then samples measured renders
+int RunSingle(size_t run, size_t samples) {
+    if (run >= kRuns) {
+        return 2;
+    }
+    Bench bench((Kernel)(run / kConfigCount), kConfigs[run % kConfigCount]);
+    bench.Render(kWarmupSamples);
+    bench.Render(samples);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    if (argc == 4 && strcmp(argv[1], "--single") == 0) {
+        return RunSingle((size_t)strtoul(argv[2], NULL, 10), (size_t)strtoul(argv[3], NULL, 10));
+    }
+
+    tides_baseline::Baseline baseline("tides_counts", &argc, argv);
+    size_t samples = 48000;
+    const char* path = "tides_counts.json";
+    bool cachegrind = false;
+    int positional = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cachegrind") == 0) {
+            cachegrind = true;
+        } else if (positional++ == 0) {
+            samples = (size_t)strtoul(argv[i], NULL, 10);
+        } else {
+            path = argv[i];
+        }
+    }
+    if (samples < kBlockSize) {
+        fprintf(stderr, "usage: tides_counts [samples] [output_json] [--cachegrind] [--baseline file]\n");
+        return 2;
+    }
+
+    PerfCounters perf;
+    const char* source = "perf_event";
+    if (cachegrind || !perf.Available()) {
+        if (!cachegrind) {
+            fprintf(stderr, "tides_counts: no hardware counters (%s), using cachegrind\n", strerror(errno));
+        }
+        source = "cachegrind";
+    }
+
+    std::vector<Counts> results(kRuns);
+    for (size_t run = 0; run < kRuns; run++) {
+        bool ok = strcmp(source, "cachegrind") == 0
+            ? MeasureCachegrind(run, samples, &results[run])
+            : MeasurePerf(&perf, run, samples, &results[run]);
+        if (!ok) {
+            fprintf(stderr, "tides_counts: %s/%s could not be measured with %s%s\n",
+                    kKernelNames[run / kConfigCount], kConfigs[run % kConfigCount].name, source,
+                    strcmp(source, "cachegrind") == 0 ? " (is valgrind installed? set $VALGRIND)" : "");
+            return 1;
+        }
+    }
+
+    FILE* json = fopen(path, "w");
+    if (!json) {
+        fprintf(stderr, "tides_counts: cannot write %s\n", path);
+        return 1;
+    }
+    fprintf(json, "{\n  \"tool\": \"tides_counts\",\n  \"format\": 1,\n  \"source\": \"%s\",\n"
+                  "  \"samples\": %zu,\n  \"sample_rate\": %.0f,\n  \"results\": [\n",
+            source, samples, kSampleRate);
+
+    printf("tides_counts: %zu samples per configuration, counts per sample from %s\n", samples, source);
+    printf("%-8s %-8s %14s %16s %12s\n", "kernel", "config", kCounterNames[0], kCounterNames[1], kCounterNames[2]);
+    for (size_t run = 0; run < kRuns; run++) {
+        const Counts& counts = results[run];
+        const char* kernel = kKernelNames[run / kConfigCount];
+        const char* config = kConfigs[run % kConfigCount].name;
+
+        fprintf(json, "    { \"kernel\": \"%s\", \"config\": \"%s\"", kernel, config);
+        printf("%-8s %-8s", kernel, config);
+        for (int c = 0; c < kCounters; c++) {
+            int width = c == 0 ? 14 : (c == 1 ? 16 : 12);
+            if (counts.valid[c]) {
+                fprintf(json, ", \"%s\": %.4f", kCounterNames[c], counts.value[c]);
+                printf(" %*.4f", width, counts.value[c]);
+                baseline.Add(std::string(kernel) + "/" + config + "/" + kCounterNames[c],
+                             "count_per_sample", counts.value[c]);  // As tides_compare expects
+            } else {
+                fprintf(json, ", \"%s\": null", kCounterNames[c]);
+                printf(" %*s", width, "-");
+            }
+        }
+        fprintf(json, " }%s\n", run + 1 < kRuns ? "," : "");
+        printf("\n");
+    }
+    fprintf(json, "  ]\n}\n");
+    fclose(json);
+    printf("wrote %s\n", path);
+    return baseline.Write() ? 0 : 1;
+}
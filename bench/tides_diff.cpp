@@ -0,0 +1,382 @@
+/**
+ * tides_diff: differential test of the Tides core's kernels against the frozen
+ * reference render (tides_reference.h)
+ *
+ * Every variant renders randomized parameter sweeps, block sizes, phase resets
+ * and phase jumps through one entry point of the core while a reference
+ * generator renders the same sequence sample by sample. Per variant it reports
+ * the largest and RMS difference against the reference, and fails when either
+ * exceeds the variant's tolerance:
+ *
+ *   variant      entry point, inputs                              max     rms
+ *   render       tides_render, constant per block                 0       0
+ *   modulated    tides_render, every parameter a signal           0       0
+ *   block        tides_render_block                               0       0
+ *   frozen       tides_render_block, sub-ulp frequencies          0       0
+ *   batch        tides_render_batch, 1 to 19 generators           1e-6    1e-7
+ *   bank         tides_bank_render, 1 to 19 generators            1e-6    1e-7
+ *
+ * The scalar kernels promise bit-identical output and get zero tolerance. The
+ * lane-parallel batch kernel mirrors the scalar chain operation for operation
+ * but is compiled as its own loop, so it is allowed rounding-level
+ * differences; so is the bank, which runs the same loop on a fixed-point phase.
+ * The bank stores quantized parameters, so its reference renders the values
+ * it keeps (see BankParams). A sample that is not finite in one render and finite in the
+ * other counts as an infinite error. New kernels are added as a row in
+ * kVariants with their own tolerance.
+ *
+ * Usage: tides_diff [trials] [seed]
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <random>
+#include <vector>
+
+#include "tides_reference.h"
+#include "tides_wrapper.h"
+
+namespace {
+
+const int kMaxBatch = 19;               // Two full lane groups and a partial one
+const int kBlocksPerTrial = 24;
+
+struct Params {
+    float frequency;
+    float pw;
+    float shape;
+    float smoothness;
+    float shift;
+};
+
+// Difference between a kernel and the reference over one variant
+struct Error {
+    double max;
+    double sum_squares;
+    unsigned long long samples;
+
+    Error() : max(0.0), sum_squares(0.0), samples(0) { }
+
+    void Add(double actual, double expected) {
+        double diff;
+        if (std::isfinite(actual) && std::isfinite(expected)) {
+            diff = std::fabs(actual - expected);
+        } else {
+            diff = (std::isnan(actual) && std::isnan(expected)) || actual == expected
+                ? 0.0 : std::numeric_limits<double>::infinity();
+        }
+        max = std::max(max, diff);
+        sum_squares += diff * diff;
+        samples++;
+    }
+
+    double Rms() const {
+        return samples ? std::sqrt(sum_squares / (double)samples) : 0.0;
+    }
+};
+
+class Sweep {
+public:
+    explicit Sweep(unsigned int seed) : rng_(seed) { }
+
+    double Uniform(double lo, double hi) {
+        return std::uniform_real_distribution<double>(lo, hi)(rng_);
+    }
+
+    int Below(int n) {
+        return std::uniform_int_distribution<int>(0, n - 1)(rng_);
+    }
+
+    // Frequencies from silent to past the fold-free range: zero, below the
+    // phase resolution, LFO to audio rates, and a few beyond one cycle per
+    // sample or below zero that the kernels clamp or hand to the scalar path
+    float Frequency() {
+        switch (Below(10)) {
+            case 0: return 0.0f;
+            case 1: return (float)std::pow(10.0, Uniform(-14.0, -8.0));
+            case 2: return (float)Uniform(0.5, 2.5);
+            case 3: return (float)-Uniform(0.0, 0.1);
+            default: return (float)std::pow(10.0, Uniform(-7.0, std::log10(0.5)));
+        }
+    }
+
+    // Values in [lo, hi], with region boundaries and the ends hit exactly
+    float Unit(float lo, float hi) {
+        static const float kEdges[] = { 0.0f, 0.1f, 0.5f, 1.0f };
+        if (Below(6) == 0) {
+            return kEdges[Below(4)];
+        }
+        return (float)Uniform(lo, hi);
+    }
+
+    Params Random() {
+        Params p;
+        p.frequency = Frequency();
+        p.pw = Unit(-0.1f, 1.1f);
+        p.shape = Unit(-0.1f, 1.1f);
+        p.smoothness = Unit(-0.2f, 1.2f);
+        p.shift = Unit(-0.1f, 1.1f);
+        return p;
+    }
+
+    // Idle generators: phase steps far below one float ulp
+    Params Frozen() {
+        Params p = Random();
+        p.frequency = Below(4) == 0 ? 0.0f : (float)std::pow(10.0, Uniform(-16.0, -10.0));
+        return p;
+    }
+
+    size_t BlockSize() {
+        static const size_t kSizes[] = { 1, 2, 3, 4, 7, 16, 31, 64, 128, 256, 1024 };
+        return kSizes[Below((int)(sizeof(kSizes) / sizeof(kSizes[0])))];
+    }
+
+private:
+    std::mt19937 rng_;
+};
+
+// Phase resets and jumps between blocks, applied to both renders
+void Disturb(Sweep* sweep, void* generator, tides_reference::SlopeGenerator* reference) {
+    switch (sweep->Below(12)) {
+        case 0:
+            tides_reset_phase(generator);
+            reference->ResetPhase();
+            break;
+        case 1: {
+            double cycles = sweep->Uniform(0.0, 1000.0);
+            tides_advance_phase(generator, cycles);
+            reference->AdvancePhase(cycles);
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+float Render(tides_reference::SlopeGenerator* reference, const Params& p) {
+    return reference->Render(p.frequency, p.pw, p.shape, p.smoothness, p.shift);
+}
+
+//----------------------------------------------------------------------------------------------
+// Variants
+
+void TrialRender(Sweep* sweep, Error* error) {
+    void* generator = tides_create();
+    tides_reference::SlopeGenerator reference;
+
+    for (int b = 0; b < kBlocksPerTrial; b++) {
+        Params p = sweep->Random();
+        size_t size = sweep->BlockSize();
+        for (size_t i = 0; i < size; i++) {
+            float out[4];
+            tides_render(generator, 1, 1, 1, p.frequency, p.pw, p.shape, p.smoothness, p.shift, 0, out);
+            error->Add(out[0], Render(&reference, p));
+        }
+        Disturb(sweep, generator, &reference);
+    }
+    tides_destroy(generator);
+}
+
+void TrialModulated(Sweep* sweep, Error* error) {
+    void* generator = tides_create();
+    tides_reference::SlopeGenerator reference;
+
+    // Every parameter glides between random targets, as from signal inlets
+    Params from = sweep->Random();
+    for (int b = 0; b < kBlocksPerTrial; b++) {
+        Params to = sweep->Random();
+        size_t size = sweep->BlockSize();
+        for (size_t i = 0; i < size; i++) {
+            float t = (float)(i + 1) / (float)size;
+            Params p;
+            p.frequency = from.frequency + (to.frequency - from.frequency) * t;
+            p.pw = from.pw + (to.pw - from.pw) * t;
+            p.shape = from.shape + (to.shape - from.shape) * t;
+            p.smoothness = from.smoothness + (to.smoothness - from.smoothness) * t;
+            p.shift = from.shift + (to.shift - from.shift) * t;
+
+            float out[4];
+            tides_render(generator, 1, 1, 1, p.frequency, p.pw, p.shape, p.smoothness, p.shift, 0, out);
+            error->Add(out[0], Render(&reference, p));
+        }
+        from = to;
+        Disturb(sweep, generator, &reference);
+    }
+    tides_destroy(generator);
+}
+
+void RenderBlocks(Sweep* sweep, Error* error, bool frozen) {
+    void* generator = tides_create();
+    tides_reference::SlopeGenerator reference;
+    std::vector<double> block;
+
+    for (int b = 0; b < kBlocksPerTrial; b++) {
+        Params p = frozen ? sweep->Frozen() : sweep->Random();
+        size_t size = sweep->BlockSize();
+        block.assign(size, 0.0);
+        tides_render_block(generator, 1, 1, 1, p.frequency, p.pw, p.shape, p.smoothness, p.shift,
+                           0, block.data(), size);
+        for (size_t i = 0; i < size; i++) {
+            error->Add(block[i], Render(&reference, p));
+        }
+        Disturb(sweep, generator, &reference);
+    }
+    tides_destroy(generator);
+}
+
+void TrialBlock(Sweep* sweep, Error* error) {
+    RenderBlocks(sweep, error, false);
+}
+
+void TrialFrozen(Sweep* sweep, Error* error) {
+    RenderBlocks(sweep, error, true);
+}
+
+void TrialBatch(Sweep* sweep, Error* error) {
+    int count = 1 + sweep->Below(kMaxBatch);
+    std::vector<void*> generators(count);
+    std::vector<tides_reference::SlopeGenerator> references(count);
+    for (int g = 0; g < count; g++) {
+        generators[g] = tides_create();
+    }
+
+    std::vector<float> params(count * 5);
+    std::vector<double> out;
+    for (int b = 0; b < kBlocksPerTrial; b++) {
+        size_t size = sweep->BlockSize();
+        std::vector<Params> p(count);
+        for (int g = 0; g < count; g++) {
+            p[g] = sweep->Random();
+            // Interleaved, to exercise the parameter stride
+            params[g * 5 + 0] = p[g].frequency;
+            params[g * 5 + 1] = p[g].pw;
+            params[g * 5 + 2] = p[g].shape;
+            params[g * 5 + 3] = p[g].smoothness;
+            params[g * 5 + 4] = p[g].shift;
+        }
+
+        out.assign(count * size, 0.0);
+        tides_render_batch(generators.data(), count, 1, 1, 1,
+                           &params[0], &params[1], &params[2], &params[3], &params[4], 5,
+                           out.data(), size, size);
+        for (int g = 0; g < count; g++) {
+            for (size_t i = 0; i < size; i++) {
+                error->Add(out[g * size + i], Render(&references[g], p[g]));
+            }
+            Disturb(sweep, generators[g], &references[g]);
+        }
+    }
+    for (int g = 0; g < count; g++) {
+        tides_destroy(generators[g]);
+    }
+}
+
+// The parameters a tides_bank keeps, with frequency wrapped and taken to
+// 2^-52 cycles so the reference's double phase stays exact: the bank holds
+// 2^-64, so on that grid both advance alike. The unit parameters are clamped
+// and taken to 2^-15. Every value is exact as a float, so the reference
+// renders what the bank does.
+Params BankParams(const Params& p) {
+    Params q = p;
+    if (p.frequency > 0.0f) {
+        double cycles = (double)p.frequency - std::floor((double)p.frequency);
+        q.frequency = (float)(std::floor(cycles * 4503599627370496.0 + 0.5) / 4503599627370496.0);
+    }
+    float* unit[] = { &q.pw, &q.shape, &q.smoothness, &q.shift };
+    for (size_t u = 0; u < 4; u++) {
+        float v = std::max(0.0f, std::min(1.0f, *unit[u]));
+        *unit[u] = std::floor(v * 32768.0f + 0.5f) / 32768.0f;
+    }
+    return q;
+}
+
+void TrialBank(Sweep* sweep, Error* error) {
+    int count = 1 + sweep->Below(kMaxBatch);
+    tides_bank* bank = tides_bank_create(count);
+    std::vector<tides_reference::SlopeGenerator> references(count);
+
+    std::vector<double> out;
+    for (int b = 0; b < kBlocksPerTrial; b++) {
+        size_t size = sweep->BlockSize();
+        std::vector<Params> p(count);
+        for (int g = 0; g < count; g++) {
+            Params raw = sweep->Random();
+            tides_bank_set(bank, g, raw.frequency, raw.pw, raw.shape, raw.smoothness, raw.shift);
+            p[g] = BankParams(raw);
+        }
+
+        // Two calls, so ranges start at any generator and lane groups are partial
+        size_t split = (size_t)sweep->Below(count + 1);
+        out.assign(count * size, 0.0);
+        tides_bank_render(bank, 0, split, out.data(), size, size);
+        tides_bank_render(bank, split, count - split, out.data() + split * size, size, size);
+        for (int g = 0; g < count; g++) {
+            for (size_t i = 0; i < size; i++) {
+                error->Add(out[g * size + i], Render(&references[g], p[g]));
+            }
+            // Banks have no phase jump; resets only
+            if (sweep->Below(12) == 0) {
+                tides_bank_reset_phase(bank, g);
+                references[g].ResetPhase();
+            }
+        }
+    }
+    tides_bank_destroy(bank);
+}
+
+struct Variant {
+    const char* name;
+    void (*trial)(Sweep* sweep, Error* error);
+    double max_tolerance;
+    double rms_tolerance;
+};
+
+const Variant kVariants[] = {
+    { "render",    TrialRender,    0.0,  0.0 },
+    { "modulated", TrialModulated, 0.0,  0.0 },
+    { "block",     TrialBlock,     0.0,  0.0 },
+    { "frozen",    TrialFrozen,    0.0,  0.0 },
+    { "batch",     TrialBatch,     1e-6, 1e-7 },
+    { "bank",      TrialBank,      1e-6, 1e-7 },
+};
+
+} // namespace
+
+int main(int argc, char** argv) {
+    int trials = argc > 1 ? atoi(argv[1]) : 200;
+    unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1u;
+
+    if (trials < 1) {
+        fprintf(stderr, "usage: tides_diff [trials] [seed]\n");
+        return 2;
+    }
+
+    printf("tides_diff: %d trials per variant, seed %u\n", trials, seed);
+    printf("%-10s %12s %12s %12s %10s %10s  %s\n",
+           "variant", "samples", "max_err", "rms_err", "max_tol", "rms_tol", "result");
+
+    int failures = 0;
+    for (size_t v = 0; v < sizeof(kVariants) / sizeof(kVariants[0]); v++) {
+        const Variant& variant = kVariants[v];
+        Sweep sweep(seed + (unsigned int)v);
+        Error error;
+        for (int t = 0; t < trials; t++) {
+            variant.trial(&sweep, &error);
+        }
+
+        bool pass = error.max <= variant.max_tolerance && error.Rms() <= variant.rms_tolerance;
+        failures += pass ? 0 : 1;
+        printf("%-10s %12llu %12.3g %12.3g %10.0e %10.0e  %s\n",
+               variant.name, error.samples, error.max, error.Rms(),
+               variant.max_tolerance, variant.rms_tolerance, pass ? "ok" : "FAIL");
+    }
+
+    if (failures) {
+        printf("tides_diff: %d variant(s) outside tolerance\n", failures);
+        return 1;
+    }
+    return 0;
+}
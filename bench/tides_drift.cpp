@@ -0,0 +1,197 @@
+/**
+ * tides_drift: accelerated long-duration phase drift test of the Tides core
+ *
+ * tide~ promises cycles as long as 11.5 days (0.000001 Hz), which rests on the
+ * double phase accumulator staying accurate over weeks of audio. This renders
+ * generators through the block kernel as fast as the core allows, for a
+ * simulated span at 48 and 96 kHz, and checks the accumulated phase every
+ * simulated hour against closed forms:
+ *
+ *   accumulation   the core's phase against n * increment computed exactly,
+ *                  where increment is the float per-sample step tide~ passes
+ *                  (frequency / sample rate, rounded to float). This is the
+ *                  double accumulator's own rounding, and may never exceed
+ *                  half an ulp of [1, 2) per sample, n * 2^-53 cycles.
+ *   quantization   the float increment against the exact frequency / sample
+ *                  rate, n * (increment - exact) cycles.
+ *
+ * Per configuration it reports the largest accumulation error, the total
+ * drift from the ideal oscillator at the end (both in cycles and seconds of
+ * time error), the period error this amounts to in seconds per cycle, and
+ * throughput in simulated days per wall-clock second. It fails when the
+ * accumulation error exceeds its bound or the phase leaves [0, 1).
+ *
+ * Ultra-low frequencies mostly take the frozen-block path and run far faster
+ * than audio rates, whose cost per simulated day is that of real rendering.
+ * Runs are spread over one thread per core; throughput is per run.
+ *
+ * Usage: tides_drift [simulated_days] [block_size] [frequency_hz ...]
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+#include "tides_wrapper.h"
+
+namespace {
+
+const double kSampleRates[] = { 48000.0, 96000.0 };
+const double kDefaultFrequencies[] = { 0.000001 };   // The README's 11.5-day cycle
+const double kSecondsPerDay = 86400.0;
+const double kCheckSeconds = 3600.0;    // Phase checked every simulated hour
+
+struct Run {
+    double sample_rate;
+    double frequency;
+};
+
+struct Result {
+    double increment_error;             // Relative error of the float increment
+    double max_accumulation;            // Largest |accumulation error| seen, cycles
+    double accumulation_bound;          // n * 2^-53 at the end, cycles
+    double accumulation;                // At the end, cycles
+    double quantization;                // At the end, cycles
+    double wall_seconds;
+    bool phase_ok;
+};
+
+// Fractional part of n * step, exact: the product is split into a rounded
+// part and its rounding error (n below 2^53, step a float)
+double ExactPhase(double n, double step) {
+    double product = n * step;
+    double error = std::fma(n, step, -product);
+    double phase = (product - std::floor(product)) + error;
+    return phase - std::floor(phase);
+}
+
+// Difference of two phases, wrapped to [-0.5, 0.5)
+double PhaseDifference(double a, double b) {
+    double d = a - b;
+    return d - std::floor(d + 0.5);
+}
+
+Result Simulate(double sample_rate, double frequency, double days, size_t block_size) {
+    // As tide~ computes it: frequency times the sample period, rounded to float
+    float increment = (float)(frequency * (1.0 / sample_rate));
+    double exact = frequency / sample_rate;
+
+    Result result;
+    result.increment_error = ((double)increment - exact) / exact;
+    result.max_accumulation = 0.0;
+    result.phase_ok = true;
+
+    void* generator = tides_create();
+    std::vector<double> block(block_size);
+    unsigned long long total = (unsigned long long)(days * kSecondsPerDay * sample_rate);
+    unsigned long long check_every = (unsigned long long)(kCheckSeconds * sample_rate);
+    unsigned long long rendered = 0;
+    double accumulation = 0.0;
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    while (rendered < total) {
+        unsigned long long next = std::min(total, rendered + check_every);
+        while (rendered < next) {
+            size_t size = (size_t)std::min<unsigned long long>(block_size, next - rendered);
+            tides_render_block(generator, 1, 1, 1, increment, 0.5f, 0.0f, 0.0f, 0.0f, 0, block.data(), size);
+            rendered += size;
+        }
+
+        double phase = tides_get_phase(generator);
+        if (!(phase >= 0.0 && phase < 1.0)) {
+            result.phase_ok = false;
+        }
+        accumulation = PhaseDifference(phase, ExactPhase((double)rendered, (double)increment));
+        result.max_accumulation = std::max(result.max_accumulation, std::fabs(accumulation));
+    }
+    result.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    tides_destroy(generator);
+
+    result.accumulation = accumulation;
+    result.accumulation_bound = (double)total * std::ldexp(1.0, -53);
+    result.quantization = (double)total * ((double)increment - exact);
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    double days = argc > 1 ? atof(argv[1]) : 14.0;
+    size_t block_size = argc > 2 ? (size_t)atol(argv[2]) : 64;
+    std::vector<double> frequencies;
+    for (int i = 3; i < argc; i++) {
+        frequencies.push_back(atof(argv[i]));
+    }
+    if (frequencies.empty()) {
+        frequencies.assign(kDefaultFrequencies,
+                           kDefaultFrequencies + sizeof(kDefaultFrequencies) / sizeof(kDefaultFrequencies[0]));
+    }
+
+    if (!(days > 0.0) || block_size < 1 || days * kSecondsPerDay * 96000.0 >= 9.0e15) {
+        fprintf(stderr, "usage: tides_drift [simulated_days] [block_size] [frequency_hz ...]\n");
+        return 2;
+    }
+    for (size_t f = 0; f < frequencies.size(); f++) {
+        if (!(frequencies[f] > 0.0 && frequencies[f] <= 1000.0)) {
+            fprintf(stderr, "tides_drift: frequencies must be in (0, 1000] Hz\n");
+            return 2;
+        }
+    }
+
+    printf("tides_drift: %.3g simulated days per run, %zu-sample blocks, phase checked hourly\n", days, block_size);
+    printf("%9s %12s %12s %12s %12s %12s %12s %14s %12s  %s\n",
+           "rate", "freq_hz", "incr_err", "accum_max", "accum_bound", "drift_cyc", "drift_s",
+           "period_err_s", "sim_days/s", "result");
+
+    std::vector<Run> runs;
+    for (size_t r = 0; r < sizeof(kSampleRates) / sizeof(kSampleRates[0]); r++) {
+        for (size_t f = 0; f < frequencies.size(); f++) {
+            Run run = { kSampleRates[r], frequencies[f] };
+            runs.push_back(run);
+        }
+    }
+
+    std::vector<Result> results(runs.size());
+    std::atomic<size_t> next(0);
+    unsigned int workers = std::max(1u, std::min(std::thread::hardware_concurrency(), (unsigned int)runs.size()));
+    std::vector<std::thread> threads;
+    for (unsigned int w = 0; w < workers; w++) {
+        threads.push_back(std::thread([&]() {
+            for (size_t i; (i = next.fetch_add(1)) < runs.size(); ) {
+                results[i] = Simulate(runs[i].sample_rate, runs[i].frequency, days, block_size);
+            }
+        }));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+
+    int failures = 0;
+    for (size_t i = 0; i < runs.size(); i++) {
+        const Result& result = results[i];
+        double hz = runs[i].frequency;
+
+        // Drift from the ideal oscillator, and the period it implies
+        double drift = result.accumulation + result.quantization;
+        double cycles = days * kSecondsPerDay * hz;
+        double period_error = -(drift / cycles) / hz;
+
+        bool pass = result.phase_ok && result.max_accumulation <= result.accumulation_bound;
+        failures += pass ? 0 : 1;
+        printf("%9.0f %12.6g %12.3g %12.3g %12.3g %12.3g %12.3g %14.3g %12.3g  %s\n",
+               runs[i].sample_rate, hz, result.increment_error, result.max_accumulation,
+               result.accumulation_bound, drift, drift / hz, period_error, days / result.wall_seconds,
+               pass ? "ok" : (result.phase_ok ? "FAIL (accumulation)" : "FAIL (phase range)"));
+    }
+
+    if (failures) {
+        printf("tides_drift: %d run(s) failed\n", failures);
+        return 1;
+    }
+    return 0;
+}
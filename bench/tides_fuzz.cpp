@@ -0,0 +1,644 @@
+/**
+ * tides_fuzz: search for the slowest blocks of the Tides core
+ *
+ * The render chain has data-dependent loops (the phase wrap and the fold) and
+ * filters that can run into denormals, so its worst-case cost per block is not
+ * known from reading the code. This harness searches the parameter and signal
+ * space for inputs that maximize the time of one 64-sample block:
+ *
+ *   - Every input is a parameter set at the first and last sample of the
+ *     block, glided or alternated per sample through tides_render (as from
+ *     signal inlets) or held constant through tides_render_block, after a
+ *     warm-up block that leaves phase and filter state behind.
+ *   - Mutations draw from special values (NaN, infinities, denormals, huge
+ *     frequencies, the 0.001/0.999 pulse width clamps, region boundaries and
+ *     their neighbouring floats), random values, small perturbations and bit
+ *     flips.
+ *   - The search keeps the slowest input per cell of kernel, frequency class,
+ *     shape region and smooth region, so one expensive family does not crowd
+ *     out the others, and mutates a random cell's input each step.
+ *
+ * An input whose warm-up and measured blocks together exceed the time budget
+ * is interrupted and reported as a timeout rather than measured: these are
+ * the runaway cases (non-finite smoothness never leaves the fold loop,
+ * frequencies of 1e30 never leave the phase wrap, large finite values of
+ * either take milliseconds per sample). Each timeout is reduced to the fields
+ * that keep it over the budget before it is reported.
+ *
+ * The slowest input of every cell is re-measured, printed, and written to a
+ * file, one per line, which --replay measures again as a regression
+ * benchmark. Cost is the best of several repetitions, in cycles on x86,
+ * generic timer ticks on AArch64 and nanoseconds elsewhere.
+ *
+ * Usage: tides_fuzz [seconds] [seed] [output_file]
+ *        tides_fuzz --replay input_file
+ */
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cmath>
+#include <csetjmp>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/time.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "tides_wrapper.h"
+
+namespace {
+
+const int kBlockSize = 64;              // Max's default signal vector
+const int kMaxWarmSamples = 4096;
+const int kSearchReps = 3;              // Repetitions per candidate during the search
+const int kReportReps = 15;             // Repetitions when re-measuring the results
+const long kBudgetMs = 20;              // CPU time per candidate, warm-up and repetitions included
+const int kMaxTimeouts = 16;
+
+#if defined(__x86_64__) || defined(__i386__)
+const char kClockUnit[] = "cycles";
+#elif defined(__aarch64__)
+const char kClockUnit[] = "ticks";
+#else
+const char kClockUnit[] = "ns";
+#endif
+
+inline uint64_t Clock() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#elif defined(__aarch64__)
+    uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+enum Kernel {
+    kKernelSignal,                      // tides_render per sample, parameters as signals
+    kKernelBlock,                       // tides_render_block, constant parameters
+    kKernels
+};
+
+enum Pattern {
+    kPatternGlide,                      // Linear from start to end over the block
+    kPatternAlternate,                  // start on even samples, end on odd ones
+    kPatterns
+};
+
+const char* const kKernelNames[kKernels] = { "signal", "block" };
+const char* const kPatternNames[kPatterns] = { "glide", "alternate" };
+
+enum { kFrequency, kPw, kShape, kSmoothness, kShift, kParams };
+
+struct Input {
+    int kernel;
+    int pattern;                        // Signal kernel only
+    int warm_samples;
+    float start[kParams];               // Block kernel renders start throughout
+    float end[kParams];
+    float warm[kParams];                // Constant parameters of the warm-up block
+};
+
+//----------------------------------------------------------------------------------------------
+// Measurement
+
+sigjmp_buf timeout_jump;
+volatile sig_atomic_t timeout_armed = 0;
+volatile double sink = 0.0;
+
+extern "C" void OnTimeout(int) {
+    if (timeout_armed) {
+        timeout_armed = 0;
+        siglongjmp(timeout_jump, 1);
+    }
+}
+
+// CPU time of the process, so that being descheduled on a busy machine does not count
+void ArmTimeout(long ms) {
+    struct itimerval timer;
+    memset(&timer, 0, sizeof(timer));
+    timer.it_value.tv_sec = ms / 1000;
+    timer.it_value.tv_usec = (ms % 1000) * 1000;
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+float SignalValue(const Input& in, int param, int i) {
+    float a = in.start[param];
+    float b = in.end[param];
+    if (in.pattern == kPatternAlternate) {
+        return (i & 1) ? b : a;
+    }
+    float t = (float)(i + 1) / (float)kBlockSize;
+    return a + (b - a) * t;
+}
+
+// Cycles of one measured block, from a freshly initialized generator
+uint64_t RenderOnce(void* storage, const Input& in, double* scratch) {
+    void* generator = tides_create_in_place(storage);
+
+    const float* w = in.warm;
+    for (int done = 0; done < in.warm_samples; done += kBlockSize) {
+        size_t size = (size_t)std::min(kBlockSize, in.warm_samples - done);
+        tides_render_block(generator, 1, 1, 1, w[kFrequency], w[kPw], w[kShape], w[kSmoothness], w[kShift],
+                           0, scratch, size);
+    }
+
+    uint64_t begin = Clock();
+    if (in.kernel == kKernelBlock) {
+        const float* p = in.start;
+        tides_render_block(generator, 1, 1, 1, p[kFrequency], p[kPw], p[kShape], p[kSmoothness], p[kShift],
+                           0, scratch, kBlockSize);
+    } else {
+        for (int i = 0; i < kBlockSize; i++) {
+            float out[4];
+            tides_render(generator, 1, 1, 1,
+                         SignalValue(in, kFrequency, i), SignalValue(in, kPw, i), SignalValue(in, kShape, i),
+                         SignalValue(in, kSmoothness, i), SignalValue(in, kShift, i), 0, out);
+            scratch[i] = out[0];
+        }
+    }
+    uint64_t end = Clock();
+
+    sink = sink + scratch[kBlockSize - 1];
+    tides_destroy_in_place(generator);
+    return end - begin;
+}
+
+// Best of reps blocks, or false when the budget ran out first
+bool Measure(const Input& in, int reps, uint64_t* cost) {
+    alignas(TIDES_GENERATOR_ALIGN) static unsigned char storage[TIDES_GENERATOR_SIZE];
+    static double scratch[kBlockSize];
+
+    if (sigsetjmp(timeout_jump, 1)) {
+        // Interrupted mid-render; the generator is abandoned and re-created next time
+        return false;
+    }
+    timeout_armed = 1;
+    ArmTimeout(kBudgetMs);
+
+    uint64_t best = UINT64_MAX;
+    for (int r = 0; r < reps; r++) {
+        best = std::min(best, RenderOnce(storage, in, scratch));
+    }
+
+    timeout_armed = 0;
+    ArmTimeout(0);
+    *cost = best;
+    return true;
+}
+
+//----------------------------------------------------------------------------------------------
+// Input space
+
+const float kSpecialValues[] = {
+    0.0f, -0.0f, 1.0e-45f, 1.0e-40f, FLT_MIN, 1.0e-12f, 1.0e-7f,
+    0.000999f, 0.001f, 0.00100001f, 0.998999f, 0.999f, 0.99900001f,
+    0.0999999f, 0.1f, 0.49999997f, 0.5f, 0.50000006f, 0.9999999f, 1.0f, 1.0000001f,
+    -1.0f, 2.0f, 9.0f, 1.0e3f, 1.0e6f, 1.0e30f, FLT_MAX, -FLT_MAX,
+    std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(),
+    std::numeric_limits<float>::quiet_NaN(),
+};
+
+class Mutator {
+public:
+    explicit Mutator(unsigned int seed) : rng_(seed) { }
+
+    int Below(int n) {
+        return std::uniform_int_distribution<int>(0, n - 1)(rng_);
+    }
+
+    double Uniform(double lo, double hi) {
+        return std::uniform_real_distribution<double>(lo, hi)(rng_);
+    }
+
+    // Ordinary values: what a patch would send
+    float Ordinary(int param) {
+        if (param == kFrequency) {
+            return (float)std::pow(10.0, Uniform(-8.0, std::log10(0.5)));
+        }
+        return (float)Uniform(0.0, 1.0);
+    }
+
+    Input Random() {
+        Input in;
+        in.kernel = Below(kKernels);
+        in.pattern = Below(kPatterns);
+        in.warm_samples = Below(2) ? 0 : 1 + Below(kMaxWarmSamples);
+        for (int p = 0; p < kParams; p++) {
+            in.start[p] = Ordinary(p);
+            in.end[p] = Below(2) ? in.start[p] : Ordinary(p);
+            in.warm[p] = Ordinary(p);
+        }
+        return in;
+    }
+
+    Input Mutate(const Input& parent) {
+        Input in = parent;
+        int count = 1 + Below(3);
+        for (int m = 0; m < count; m++) {
+            MutateOnce(&in);
+        }
+        return in;
+    }
+
+private:
+    std::mt19937 rng_;
+
+    float* Field(Input* in) {
+        float* sets[] = { in->start, in->end, in->warm };
+        return &sets[Below(3)][Below(kParams)];
+    }
+
+    void MutateOnce(Input* in) {
+        switch (Below(8)) {
+            case 0:
+            case 1:
+                *Field(in) = kSpecialValues[Below((int)(sizeof(kSpecialValues) / sizeof(kSpecialValues[0])))];
+                break;
+            case 2: {
+                float* f = Field(in);
+                *f = (float)(*f * (1.0 + std::normal_distribution<double>(0.0, 0.1)(rng_)));
+                break;
+            }
+            case 3: {
+                int p = Below(kParams);
+                float* sets[] = { in->start, in->end, in->warm };
+                sets[Below(3)][p] = Ordinary(p);
+                break;
+            }
+            case 4: {
+                float* f = Field(in);
+                uint32_t bits;
+                memcpy(&bits, f, sizeof(bits));
+                bits ^= 1u << Below(32);
+                memcpy(f, &bits, sizeof(bits));
+                break;
+            }
+            case 5: {
+                int p = Below(kParams);
+                if (Below(2)) {
+                    in->end[p] = in->start[p];
+                } else {
+                    in->warm[p] = in->start[p];
+                }
+                break;
+            }
+            case 6:
+                in->kernel = Below(kKernels);
+                in->pattern = Below(kPatterns);
+                break;
+            default: {
+                static const int kWarm[] = { 0, 1, kBlockSize, kMaxWarmSamples };
+                in->warm_samples = Below(2) ? kWarm[Below(4)] : Below(kMaxWarmSamples + 1);
+                break;
+            }
+        }
+    }
+};
+
+//----------------------------------------------------------------------------------------------
+// Cells: the kernel and the regions selected after the core's clamping. Frequency and smooth
+// classes are ordered by cost and take the most expensive of the parameter sets rendered.
+
+enum { kFrequencyClasses = 3, kShapeClasses = 3, kSmoothClasses = 4 };
+const int kCells = kKernels * kFrequencyClasses * kShapeClasses * kSmoothClasses;
+
+const char* const kFrequencyNames[kFrequencyClasses] = { "none", "audio", "fast" };
+const char* const kShapeNames[kShapeClasses] = { "linear", "exp", "log" };
+const char* const kSmoothNames[kSmoothClasses] = { "off", "filter", "fold", "overfold" };
+
+int FrequencyClass(float f) {
+    if (f > 0.5f) return 2;             // More than the clamp tide~ applies, up to infinity
+    if (f > 0.0f) return 1;
+    return 0;                           // Zero, negative or NaN: no phase advance
+}
+
+int ShapeClass(float s) {
+    s = std::max(0.0f, std::min(1.0f, s));
+    if (s < 0.1f || s == 0.5f) return 0;
+    return s < 0.5f ? 1 : 2;
+}
+
+int SmoothClass(float s) {
+    if (s < 0.1f) return 0;
+    if (s < 0.5f) return 1;
+    if (s > 1.0f) return 3;             // Past the 0-1 range, including infinity
+    if (s > 0.5f) return 2;
+    return 0;                           // Exactly 0.5, or NaN
+}
+
+// Highest class of param over the parameter sets the input renders
+int WorstClass(const Input& in, int param, int (*classify)(float)) {
+    int worst = classify(in.start[param]);
+    if (in.kernel == kKernelSignal) {
+        worst = std::max(worst, classify(in.end[param]));
+    }
+    if (in.warm_samples > 0) {
+        worst = std::max(worst, classify(in.warm[param]));
+    }
+    return worst;
+}
+
+int CellOf(const Input& in) {
+    int cell = in.kernel;
+    cell = cell * kFrequencyClasses + WorstClass(in, kFrequency, FrequencyClass);
+    cell = cell * kShapeClasses + ShapeClass(in.start[kShape]);
+    cell = cell * kSmoothClasses + WorstClass(in, kSmoothness, SmoothClass);
+    return cell;
+}
+
+std::string CellName(const Input& in) {
+    std::string name = kKernelNames[in.kernel];
+    name += std::string("/") + kFrequencyNames[WorstClass(in, kFrequency, FrequencyClass)];
+    name += std::string("/") + kShapeNames[ShapeClass(in.start[kShape])];
+    name += std::string("/") + kSmoothNames[WorstClass(in, kSmoothness, SmoothClass)];
+    return name;
+}
+
+//----------------------------------------------------------------------------------------------
+// Input files: one input per line, floats in round-trip precision
+
+void WriteInput(FILE* file, const Input& in) {
+    fprintf(file, "%s %s %d", kKernelNames[in.kernel], kPatternNames[in.pattern], in.warm_samples);
+    const float* sets[] = { in.start, in.end, in.warm };
+    for (int s = 0; s < 3; s++) {
+        for (int p = 0; p < kParams; p++) {
+            fprintf(file, " %.9g", sets[s][p]);
+        }
+    }
+}
+
+bool ParseInput(const char* line, Input* in) {
+    char kernel[16], pattern[16];
+    int consumed = 0;
+    if (sscanf(line, "%15s %15s %d%n", kernel, pattern, &in->warm_samples, &consumed) != 3) {
+        return false;
+    }
+    in->kernel = strcmp(kernel, kKernelNames[kKernelBlock]) == 0 ? kKernelBlock : kKernelSignal;
+    in->pattern = strcmp(pattern, kPatternNames[kPatternAlternate]) == 0 ? kPatternAlternate : kPatternGlide;
+    in->warm_samples = std::max(0, std::min(kMaxWarmSamples, in->warm_samples));
+
+    // strtof reads nan and inf, which the scanf float conversions do not everywhere
+    const char* cursor = line + consumed;
+    float* sets[] = { in->start, in->end, in->warm };
+    for (int s = 0; s < 3; s++) {
+        for (int p = 0; p < kParams; p++) {
+            char* next;
+            sets[s][p] = strtof(cursor, &next);
+            if (next == cursor) {
+                return false;
+            }
+            cursor = next;
+        }
+    }
+    return true;
+}
+
+void PrintHeader() {
+    printf("%-30s %12s %10s %8s  %s\n", "cell", "cost/block", "per_sample", "vs_base", "input");
+}
+
+void PrintRow(const Input& in, const char* cost, double per_sample, double ratio) {
+    printf("%-30s %12s %10.1f %7.1fx  ", CellName(in).c_str(), cost, per_sample, ratio);
+    WriteInput(stdout, in);
+    printf("\n");
+}
+
+// A plain audio-rate block, for scale and as the neutral values of Minimize
+Input BaselineInput() {
+    Input in;
+    in.kernel = kKernelBlock;
+    in.pattern = kPatternGlide;
+    in.warm_samples = 0;
+    const float base[kParams] = { 0.01f, 0.5f, 0.0f, 0.0f, 0.0f };
+    for (int p = 0; p < kParams; p++) {
+        in.start[p] = in.end[p] = in.warm[p] = base[p];
+    }
+    return in;
+}
+
+uint64_t BaselineCost() {
+    uint64_t cost = 0;
+    Measure(BaselineInput(), kReportReps, &cost);
+    return std::max<uint64_t>(cost, 1);
+}
+
+// Puts back neutral values, one field at a time, as long as the input still times out,
+// leaving the parameters that cause the runaway
+Input Minimize(const Input& timeout) {
+    const Input neutral = BaselineInput();
+    Input in = timeout;
+    uint64_t cost;
+
+    Input candidate = in;
+    candidate.warm_samples = 0;
+    if (!Measure(candidate, kSearchReps, &cost)) {
+        in = candidate;
+    }
+    float* sets[] = { in.start, in.end, in.warm };
+    for (int s = 0; s < 3; s++) {
+        for (int p = 0; p < kParams; p++) {
+            float kept = sets[s][p];
+            if (memcmp(&kept, &neutral.start[p], sizeof(float)) == 0) {
+                continue;
+            }
+            sets[s][p] = neutral.start[p];
+            if (Measure(in, kSearchReps, &cost)) {
+                sets[s][p] = kept;
+            }
+        }
+    }
+    if (in.warm_samples == 0) {
+        memcpy(in.warm, neutral.warm, sizeof(in.warm));
+    }
+    return in;
+}
+
+int Replay(const char* path) {
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "tides_fuzz: cannot read %s\n", path);
+        return 2;
+    }
+
+    uint64_t base = BaselineCost();
+    printf("tides_fuzz: replaying %s, %d-sample blocks, best of %d, baseline %llu %s/block\n",
+           path, kBlockSize, kReportReps, (unsigned long long)base, kClockUnit);
+    PrintHeader();
+
+    char line[1024];
+    int count = 0;
+    while (fgets(line, sizeof(line), file)) {
+        Input in;
+        if (line[0] == '#' || !ParseInput(line, &in)) {
+            continue;
+        }
+        uint64_t cost;
+        char text[32];
+        if (Measure(in, kReportReps, &cost)) {
+            snprintf(text, sizeof(text), "%llu", (unsigned long long)cost);
+            PrintRow(in, text, (double)cost / kBlockSize, (double)cost / (double)base);
+        } else {
+            snprintf(text, sizeof(text), ">%ldms", kBudgetMs);
+            PrintRow(in, text, 0.0, 0.0);
+        }
+        count++;
+    }
+    fclose(file);
+    printf("tides_fuzz: %d inputs\n", count);
+    return 0;
+}
+
+struct Entry {
+    bool used;
+    Input input;
+    uint64_t cost;
+};
+
+bool SlowerFirst(const Entry& a, const Entry& b) {
+    return a.cost > b.cost;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    struct sigaction action;
+    memset(&action, 0, sizeof(action));
+    action.sa_handler = OnTimeout;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGPROF, &action, NULL);
+
+    if (argc > 1 && strcmp(argv[1], "--replay") == 0) {
+        if (argc < 3) {
+            fprintf(stderr, "usage: tides_fuzz --replay input_file\n");
+            return 2;
+        }
+        return Replay(argv[2]);
+    }
+
+    double seconds = argc > 1 ? atof(argv[1]) : 20.0;
+    unsigned int seed = argc > 2 ? (unsigned int)strtoul(argv[2], NULL, 10) : 1u;
+    const char* output = argc > 3 ? argv[3] : "tides_fuzz_slowest.txt";
+    if (!(seconds > 0.0)) {
+        fprintf(stderr, "usage: tides_fuzz [seconds] [seed] [output_file]\n");
+        return 2;
+    }
+
+    uint64_t base = BaselineCost();
+    printf("tides_fuzz: %.0f s search, seed %u, %d-sample blocks, %ld ms budget per input\n",
+           seconds, seed, kBlockSize, kBudgetMs);
+    printf("baseline (block, 0.01 cycles/sample, no shaping or smoothing): %llu %s/block\n",
+           (unsigned long long)base, kClockUnit);
+
+    Mutator mutator(seed);
+    std::vector<Entry> cells(kCells);
+    std::vector<int> occupied;
+    std::vector<Input> timeouts;
+    std::vector<int> timeout_cells;
+    unsigned long long evaluations = 0;
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::now()
+        + std::chrono::microseconds((long long)(seconds * 1e6));
+    while (std::chrono::steady_clock::now() < deadline) {
+        Input in = occupied.empty() || mutator.Below(10) == 0
+            ? mutator.Random()
+            : mutator.Mutate(cells[occupied[mutator.Below((int)occupied.size())]].input);
+        int cell = CellOf(in);
+        uint64_t cost;
+        evaluations++;
+
+        if (!Measure(in, kSearchReps, &cost)) {
+            // One timeout per cell is enough to reproduce it; they are not mutated further
+            if ((int)timeouts.size() < kMaxTimeouts
+                && std::find(timeout_cells.begin(), timeout_cells.end(), cell) == timeout_cells.end()) {
+                timeouts.push_back(in);
+                timeout_cells.push_back(cell);
+            }
+            continue;
+        }
+        if (!cells[cell].used) {
+            occupied.push_back(cell);
+        }
+        if (!cells[cell].used || cost > cells[cell].cost) {
+            cells[cell].used = true;
+            cells[cell].input = in;
+            cells[cell].cost = cost;
+        }
+    }
+
+    // Re-measure the winners with more repetitions before ranking them
+    std::vector<Entry> results;
+    for (size_t c = 0; c < occupied.size(); c++) {
+        Entry entry = cells[occupied[c]];
+        if (!Measure(entry.input, kReportReps, &entry.cost)) {
+            timeouts.push_back(entry.input);
+            continue;
+        }
+        results.push_back(entry);
+    }
+    std::sort(results.begin(), results.end(), SlowerFirst);
+
+    std::vector<Input> minimal;
+    for (size_t i = 0; i < timeouts.size(); i++) {
+        Input in = Minimize(timeouts[i]);
+        bool seen = false;
+        for (size_t j = 0; j < minimal.size(); j++) {
+            seen = seen || memcmp(&minimal[j], &in, sizeof(in)) == 0;
+        }
+        if (!seen) {
+            minimal.push_back(in);
+        }
+    }
+    timeouts.swap(minimal);
+
+    printf("%llu inputs tried, %zu cells filled, %zu distinct timeouts\n\n",
+           evaluations, results.size(), timeouts.size());
+    PrintHeader();
+    for (size_t i = 0; i < results.size(); i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "%llu", (unsigned long long)results[i].cost);
+        PrintRow(results[i].input, text, (double)results[i].cost / kBlockSize,
+                 (double)results[i].cost / (double)base);
+    }
+    if (!timeouts.empty()) {
+        printf("\ntimeouts, reduced to the fields that keep them over %ld ms:\n", kBudgetMs);
+        for (size_t i = 0; i < timeouts.size(); i++) {
+            char text[32];
+            snprintf(text, sizeof(text), ">%ldms", kBudgetMs);
+            PrintRow(timeouts[i], text, 0.0, 0.0);
+        }
+    }
+
+    FILE* file = fopen(output, "w");
+    if (!file) {
+        fprintf(stderr, "tides_fuzz: cannot write %s\n", output);
+        return 1;
+    }
+    fprintf(file, "# tides_fuzz seed %u: kernel pattern warm_samples, then frequency pw shape smoothness shift\n"
+                  "# at the first sample, at the last sample and during the warm-up. Slowest first, timeouts last.\n",
+            seed);
+    for (size_t i = 0; i < results.size(); i++) {
+        WriteInput(file, results[i].input);
+        fprintf(file, "\n");
+    }
+    for (size_t i = 0; i < timeouts.size(); i++) {
+        WriteInput(file, timeouts[i]);
+        fprintf(file, "\n");
+    }
+    fclose(file);
+    printf("\nwrote %s (tides_fuzz --replay %s)\n", output, output);
+    return 0;
+}
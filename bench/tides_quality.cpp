@@ -0,0 +1,387 @@
+/**
+ * tides_quality: aliasing and distortion against CPU cost, per render configuration
+ *
+ * Renders stepped frequency sweeps of several waveforms through each
+ * configuration in kConfigs, measures the output spectrum with an FFT and
+ * reports, per tone, the aliasing energy and THD next to the configuration's
+ * cost in ns per output sample:
+ *
+ *   alias_db   energy away from the harmonics of the tone, relative to the
+ *              total (DC excluded): partials folded back from above Nyquist
+ *   thd_db     harmonics 2 and up below Nyquist, relative to the fundamental;
+ *              for these waveforms mostly a property of the shape itself
+ *
+ * Tones sit on odd FFT bins and the per-sample phase step is then an exact
+ * binary fraction, so every partial, folded or not, lands on a bin and no
+ * window is needed; a folded partial never lands on a harmonic bin.
+ *
+ * The configurations are the core's kernels at the native rate, plus
+ * oversampling around the block kernel: rendering at 2, 4 or 8 times the rate
+ * and decimating with a Kaiser-windowed sinc (passband to 0.4, stopband from
+ * 0.5 of the output rate, about 90 dB). The decimator is a plain FIR rather
+ * than a half-band cascade, so its cost is an upper bound for oversampling.
+ * New anti-aliasing or approximation options are added as rows of kConfigs.
+ *
+ * Every tone is written as a CSV row (config, kernel, oversample, waveform,
+ * f0_hz, alias_db, thd_db, ns_per_sample) to the output file, and a summary
+ * with the worst aliasing per waveform is printed. With --baseline, every timed
+ * repetition of every tone is written to a baseline file (tides_baseline.h),
+ * as ns/sample per configuration and waveform.
+ *
+ * Usage: tides_quality [output_csv] [--baseline file]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "tides_baseline.h"
+#include "tides_wrapper.h"
+
+namespace {
+
+const double kSampleRate = 48000.0;
+const int kFftBits = 16;
+const size_t kFftSize = (size_t)1 << kFftBits;
+const size_t kBlockSize = 64;           // Per call at the native rate, as in Max
+const int kBatchLanes = 8;
+const int kTimingReps = 3;
+const double kPi = 3.14159265358979323846;
+
+enum Kernel { kBlock, kSignal, kBatch };
+const char* const kKernelNames[] = { "block", "signal", "batch" };
+
+struct Config {
+    const char* name;
+    Kernel kernel;
+    int oversample;                     // Power of two
+};
+
+const Config kConfigs[] = {
+    { "block",     kBlock,  1 },
+    { "signal",    kSignal, 1 },
+    { "batch",     kBatch,  1 },
+    { "block_os2", kBlock,  2 },
+    { "block_os4", kBlock,  4 },
+    { "block_os8", kBlock,  8 },
+};
+
+struct Waveform {
+    const char* name;
+    float pw;
+    float shape;
+    float smoothness;
+};
+
+const Waveform kWaveforms[] = {
+    { "triangle", 0.5f,   0.0f, 0.0f },
+    { "saw",      0.999f, 0.0f, 0.0f },   // Steepest fall the pw clamp allows
+    { "curved",   0.5f,   0.9f, 0.0f },   // Logarithmic shaping
+    { "folded",   0.5f,   0.0f, 0.6f },   // Mild wavefolding (full folding cancels the fundamental)
+};
+
+const double kTones[] = { 55.0, 110.0, 220.0, 440.0, 880.0, 1760.0, 3520.0, 7040.0, 14080.0 };
+
+const size_t kConfigCount = sizeof(kConfigs) / sizeof(kConfigs[0]);
+const size_t kWaveformCount = sizeof(kWaveforms) / sizeof(kWaveforms[0]);
+const size_t kToneCount = sizeof(kTones) / sizeof(kTones[0]);
+
+//----------------------------------------------------------------------------------------------
+// Decimation
+
+// Kaiser-windowed sinc for decimating by factor, unity gain at DC
+std::vector<double> DecimationFilter(int factor) {
+    const double beta = 9.0;
+    const double cutoff = 0.45 / factor;                // Cycles per input sample
+    int taps = 57 * factor + 1;                         // Transition 0.1 of the output rate
+
+    std::vector<double> h(taps);
+    double i0_beta = 0.0;
+    double sum = 0.0;
+    for (int k = 0; k < 50; k++) {
+        double term = std::pow(beta / 2.0, k) / std::tgamma(k + 1.0);
+        i0_beta += term * term;
+    }
+    for (int n = 0; n < taps; n++) {
+        double x = n - (taps - 1) / 2.0;
+        double sinc = x == 0.0 ? 2.0 * cutoff : std::sin(2.0 * kPi * cutoff * x) / (kPi * x);
+        double r = 2.0 * n / (taps - 1) - 1.0;
+        double arg = beta * std::sqrt(std::max(0.0, 1.0 - r * r));
+        double i0 = 0.0;
+        for (int k = 0; k < 50; k++) {
+            double term = std::pow(arg / 2.0, k) / std::tgamma(k + 1.0);
+            i0 += term * term;
+        }
+        h[n] = sinc * i0 / i0_beta;
+        sum += h[n];
+    }
+    for (int n = 0; n < taps; n++) {
+        h[n] /= sum;
+    }
+    return h;
+}
+
+//----------------------------------------------------------------------------------------------
+// Rendering
+
+class Renderer {
+public:
+    Renderer(const Config& config, const Waveform& waveform, float increment)
+        : config_(config), waveform_(waveform), increment_(increment / (float)config.oversample),
+          generators_(config.kernel == kBatch ? kBatchLanes : 1) {
+        for (size_t g = 0; g < generators_.size(); g++) {
+            generators_[g] = tides_create();
+        }
+        if (config.oversample > 1) {
+            filter_ = DecimationFilter(config.oversample);
+            history_.assign(filter_.size() - 1, 0.0);
+        }
+    }
+
+    ~Renderer() {
+        for (size_t g = 0; g < generators_.size(); g++) {
+            tides_destroy(generators_[g]);
+        }
+    }
+
+    // Renders size output samples, continuing from the previous call
+    void Render(double* out, size_t size) {
+        if (config_.oversample == 1) {
+            RenderNative(out, size);
+            return;
+        }
+
+        // The filter runs over the previous call's tail and this call's input
+        int factor = config_.oversample;
+        size_t taps = filter_.size();
+        input_.resize(history_.size() + size * factor);
+        std::copy(history_.begin(), history_.end(), input_.begin());
+        RenderNative(&input_[history_.size()], size * factor);
+
+        for (size_t i = 0; i < size; i++) {
+            // Four partial sums, so the loop is not bound by the add latency
+            const double* x = &input_[(i + 1) * factor - 1];
+            double acc[4] = { 0.0, 0.0, 0.0, 0.0 };
+            size_t k = 0;
+            for (; k + 4 <= taps; k += 4) {
+                acc[0] += filter_[k] * x[k];
+                acc[1] += filter_[k + 1] * x[k + 1];
+                acc[2] += filter_[k + 2] * x[k + 2];
+                acc[3] += filter_[k + 3] * x[k + 3];
+            }
+            for (; k < taps; k++) {
+                acc[0] += filter_[k] * x[k];
+            }
+            out[i] = (acc[0] + acc[1]) + (acc[2] + acc[3]);
+        }
+        std::copy(input_.end() - history_.size(), input_.end(), history_.begin());
+    }
+
+private:
+    Config config_;
+    Waveform waveform_;
+    float increment_;
+    std::vector<void*> generators_;
+    std::vector<double> filter_;        // Symmetric, so applied without reversal
+    std::vector<double> history_;
+    std::vector<double> input_;
+    std::vector<double> lanes_;
+
+    void RenderNative(double* out, size_t size) {
+        size_t block = kBlockSize * config_.oversample;
+        for (size_t done = 0; done < size; done += block) {
+            size_t n = std::min(block, size - done);
+            RenderCall(out + done, n);
+        }
+    }
+
+    void RenderCall(double* out, size_t size) {
+        const Waveform& w = waveform_;
+        switch (config_.kernel) {
+            case kBlock:
+                tides_render_block(generators_[0], 1, 1, 1, increment_, w.pw, w.shape, w.smoothness, 0.0f,
+                                   0, out, size);
+                break;
+            case kSignal:
+                for (size_t i = 0; i < size; i++) {
+                    float sample[4];
+                    tides_render(generators_[0], 1, 1, 1, increment_, w.pw, w.shape, w.smoothness, 0.0f,
+                                 0, sample);
+                    out[i] = sample[0];
+                }
+                break;
+            case kBatch: {
+                float frequency[kBatchLanes], pw[kBatchLanes], shape[kBatchLanes];
+                float smoothness[kBatchLanes], shift[kBatchLanes];
+                for (int l = 0; l < kBatchLanes; l++) {
+                    frequency[l] = increment_;
+                    pw[l] = w.pw;
+                    shape[l] = w.shape;
+                    smoothness[l] = w.smoothness;
+                    shift[l] = 0.0f;
+                }
+                lanes_.resize(kBatchLanes * size);
+                tides_render_batch(generators_.data(), kBatchLanes, 1, 1, 1,
+                                   frequency, pw, shape, smoothness, shift, 1, lanes_.data(), size, size);
+                std::copy(lanes_.begin(), lanes_.begin() + size, out);
+                break;
+            }
+        }
+    }
+};
+
+//----------------------------------------------------------------------------------------------
+// Analysis
+
+// In-place radix-2 FFT
+void Fft(std::vector<double>* re, std::vector<double>* im) {
+    size_t n = re->size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap((*re)[i], (*re)[j]);
+            std::swap((*im)[i], (*im)[j]);
+        }
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        double angle = -2.0 * kPi / (double)len;
+        for (size_t i = 0; i < n; i += len) {
+            for (size_t k = 0; k < len / 2; k++) {
+                double wr = std::cos(angle * (double)k);
+                double wi = std::sin(angle * (double)k);
+                size_t a = i + k;
+                size_t b = a + len / 2;
+                double xr = (*re)[b] * wr - (*im)[b] * wi;
+                double xi = (*re)[b] * wi + (*im)[b] * wr;
+                (*re)[b] = (*re)[a] - xr;
+                (*im)[b] = (*im)[a] - xi;
+                (*re)[a] += xr;
+                (*im)[a] += xi;
+            }
+        }
+    }
+}
+
+double Decibels(double ratio) {
+    return ratio > 0.0 ? std::max(-200.0, 10.0 * std::log10(ratio)) : -200.0;
+}
+
+// Aliasing and THD of one period-exact block whose fundamental sits on bin
+void Analyze(const std::vector<double>& signal, size_t bin, double* alias_db, double* thd_db) {
+    std::vector<double> re(signal);
+    std::vector<double> im(signal.size(), 0.0);
+    Fft(&re, &im);
+
+    double total = 0.0, alias = 0.0, harmonics = 0.0, fundamental = 0.0;
+    for (size_t b = 1; b < kFftSize / 2; b++) {
+        double power = re[b] * re[b] + im[b] * im[b];
+        total += power;
+        if (b % bin != 0) {
+            alias += power;
+        } else if (b == bin) {
+            fundamental = power;
+        } else {
+            harmonics += power;
+        }
+    }
+    *alias_db = Decibels(total > 0.0 ? alias / total : 0.0);
+    *thd_db = Decibels(fundamental > 0.0 ? harmonics / fundamental : 0.0);
+}
+
+struct Measurement {
+    double f0;
+    double alias_db;
+    double thd_db;
+    double ns_per_sample;
+    std::vector<double> rep_ns_per_sample;  // Every timed repetition
+};
+
+Measurement Measure(const Config& config, const Waveform& waveform, double tone) {
+    // Nearest odd bin: a step of bin / N cycles is exact in float
+    size_t bin = (size_t)std::floor(tone * kFftSize / kSampleRate / 2.0) * 2 + 1;
+    float increment = (float)((double)bin / (double)kFftSize);
+
+    Renderer renderer(config, waveform, increment);
+    std::vector<double> signal(kFftSize);
+
+    // One period of the analysis length to settle filters and decimator
+    renderer.Render(signal.data(), kFftSize);
+
+    Measurement m;
+    double per_sample = 1.0 / (double)kFftSize / (config.kernel == kBatch ? kBatchLanes : 1);
+    double best = 1e300;
+    for (int r = 0; r < kTimingReps; r++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        renderer.Render(signal.data(), kFftSize);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        m.rep_ns_per_sample.push_back(ns * per_sample);
+        best = std::min(best, ns);
+    }
+
+    m.f0 = (double)bin * kSampleRate / (double)kFftSize;
+    m.ns_per_sample = best * per_sample;
+    Analyze(signal, bin, &m.alias_db, &m.thd_db);
+    return m;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    tides_baseline::Baseline baseline("tides_quality", &argc, argv);
+    const char* path = argc > 1 ? argv[1] : "tides_quality.csv";
+    FILE* csv = fopen(path, "w");
+    if (!csv) {
+        fprintf(stderr, "tides_quality: cannot write %s\n", path);
+        return 1;
+    }
+    fprintf(csv, "config,kernel,oversample,waveform,f0_hz,alias_db,thd_db,ns_per_sample\n");
+
+    printf("tides_quality: %zu configurations, %zu waveforms, %zu tones from %.0f to %.0f Hz at %.0f Hz\n",
+           kConfigCount, kWaveformCount, kToneCount, kTones[0], kTones[kToneCount - 1], kSampleRate);
+    printf("worst aliasing over the sweep (dB below total), cost per output sample\n");
+    printf("%-10s %10s", "config", "ns/sample");
+    for (size_t w = 0; w < kWaveformCount; w++) {
+        printf(" %10s", kWaveforms[w].name);
+    }
+    printf("\n");
+
+    for (size_t c = 0; c < kConfigCount; c++) {
+        const Config& config = kConfigs[c];
+        double ns_sum = 0.0;
+        std::vector<double> worst(kWaveformCount, -200.0);
+
+        for (size_t w = 0; w < kWaveformCount; w++) {
+            for (size_t t = 0; t < kToneCount; t++) {
+                Measurement m = Measure(config, kWaveforms[w], kTones[t]);
+                worst[w] = std::max(worst[w], m.alias_db);
+                ns_sum += m.ns_per_sample;
+                fprintf(csv, "%s,%s,%d,%s,%.3f,%.2f,%.2f,%.3f\n",
+                        config.name, kKernelNames[config.kernel], config.oversample, kWaveforms[w].name,
+                        m.f0, m.alias_db, m.thd_db, m.ns_per_sample);
+                for (size_t r = 0; r < m.rep_ns_per_sample.size(); r++) {
+                    baseline.Add(std::string(config.name) + "/" + kWaveforms[w].name, "ns_per_sample",
+                                 m.rep_ns_per_sample[r]);
+                }
+            }
+        }
+
+        printf("%-10s %10.2f", config.name, ns_sum / (double)(kWaveformCount * kToneCount));
+        for (size_t w = 0; w < kWaveformCount; w++) {
+            printf(" %10.1f", worst[w]);
+        }
+        printf("\n");
+        fflush(stdout);
+    }
+
+    fclose(csv);
+    printf("wrote %s\n", path);
+    return baseline.Write() ? 0 : 1;
+}
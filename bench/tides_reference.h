@@ -0,0 +1,166 @@
+/**
+ * Frozen reference of the Tides core's per-sample render chain
+ *
+ * A copy of the original PolySlopeGenerator's scalar path (parameter clamping,
+ * GenerateRamp, ApplyShaping, ApplySmoothing and ResetPhase) as it stood before
+ * the block, frozen and lane-parallel kernels were derived from it. One method
+ * was added after the original: AdvancePhase, the analytic phase skip tide~
+ * uses across bypassed vectors, so tides_diff can check tides_advance_phase
+ * too. Optimized kernels in tides_wrapper.cpp are checked against this class
+ * by tides_diff.
+ *
+ * Loop mode only, which is what every host renders. Do not optimize or tidy
+ * this file: its only job is to keep computing what the original code did.
+ */
+
+#ifndef TIDES_REFERENCE_H
+#define TIDES_REFERENCE_H
+
+#include <algorithm>
+#include <cmath>
+
+namespace tides_reference {
+
+class SlopeGenerator {
+public:
+    SlopeGenerator() {
+        Init();
+    }
+
+    void Init() {
+        frequency_ = 0.01f;
+        pw_ = 0.5f;
+        shift_ = 0.0f;
+        shape_ = 0.0f;
+
+        phase_ = 0.0f;
+        ramp_value_ = 0.0f;
+        in_rising_phase_ = true;
+
+        filter_lp_1_ = 0.0f;
+        filter_lp_2_ = 0.0f;
+    }
+
+    void ResetPhase() {
+        phase_ = 0.0;
+        ramp_value_ = 0.0f;
+
+        filter_lp_1_ = 0.0f;
+        filter_lp_2_ = 0.0f;
+    }
+
+    // Not in the original: the phase skip added with tide~'s bypass
+    void AdvancePhase(double cycles) {
+        if (!(cycles > 0.0)) return;
+
+        phase_ += cycles;
+        phase_ -= std::floor(phase_);
+    }
+
+    // One sample of RAMP_MODE_LOOPING with the given parameters
+    float Render(float frequency, float pw, float shape, float smoothness, float shift) {
+        frequency_ = std::max(frequency, 0.0f);
+        pw_ = std::max(0.001f, std::min(0.999f, pw));
+        shape_ = std::max(0.0f, std::min(1.0f, shape));
+        shift_ = std::max(0.0f, std::min(1.0f, shift));
+
+        float ramp_output = GenerateRamp(frequency_, shift_);
+        float shaped = ApplyShaping(ramp_output, shape_, pw_);
+        return ApplySmoothing(shaped, smoothness);
+    }
+
+private:
+    float frequency_;
+    float pw_;
+    float shift_;
+    float shape_;
+
+    double phase_;
+    float ramp_value_;
+
+    float filter_lp_1_;
+    float filter_lp_2_;
+
+    bool in_rising_phase_;
+
+    float GenerateRamp(float frequency, float phase_shift) {
+        phase_ += (double)frequency;
+
+        while (phase_ >= 1.0) {
+            phase_ -= 1.0;
+        }
+
+        float float_phase = (float)phase_;
+        float effective_phase = fmodf(float_phase + phase_shift, 1.0f);
+
+        in_rising_phase_ = (effective_phase < pw_);
+
+        if (in_rising_phase_) {
+            ramp_value_ = effective_phase / pw_;
+        } else {
+            ramp_value_ = 1.0f - (effective_phase - pw_) / (1.0f - pw_);
+        }
+
+        ramp_value_ = ramp_value_ * 2.0f - 1.0f;
+        return ramp_value_;
+    }
+
+    float ApplyShaping(float input, float shape, float slope) {
+        float unipolar = (input + 1.0f) * 0.5f;
+        float shaped;
+
+        if (shape < 0.1f) {
+            shaped = unipolar;
+        } else if (shape < 0.5f) {
+            float curve = (shape - 0.1f) / 0.4f;
+            if (in_rising_phase_) {
+                shaped = powf(unipolar, 1.0f + curve * 2.0f);
+            } else {
+                shaped = 1.0f - powf(1.0f - unipolar, 1.0f + curve * 2.0f);
+            }
+        } else if (shape > 0.5f) {
+            float curve = (shape - 0.5f) * 2.0f;
+            if (in_rising_phase_) {
+                shaped = 1.0f - powf(1.0f - unipolar, 1.0f + curve * 2.0f);
+            } else {
+                shaped = powf(unipolar, 1.0f + curve * 2.0f);
+            }
+        } else {
+            shaped = unipolar;
+        }
+
+        return shaped * 2.0f - 1.0f;
+    }
+
+    float ApplySmoothing(float input, float smoothness) {
+        if (smoothness < 0.1f) {
+            return input;
+        } else if (smoothness < 0.5f) {
+            float cutoff = (smoothness - 0.1f) / 0.4f;
+            cutoff = cutoff * cutoff;
+            cutoff = std::max(cutoff, 0.01f);
+
+            filter_lp_1_ += (input - filter_lp_1_) * cutoff;
+            filter_lp_2_ += (filter_lp_1_ - filter_lp_2_) * cutoff;
+            return filter_lp_2_;
+        } else if (smoothness > 0.5f) {
+            float fold_amount = (smoothness - 0.5f) * 2.0f;
+            float folded = input * (1.0f + fold_amount * 8.0f);
+
+            while (folded > 1.0f || folded < -1.0f) {
+                if (folded > 1.0f) {
+                    folded = 2.0f - folded;
+                } else if (folded < -1.0f) {
+                    folded = -2.0f - folded;
+                }
+            }
+            return folded;
+        } else {
+            return input;
+        }
+    }
+};
+
+} // namespace tides_reference
+
+#endif // TIDES_REFERENCE_H
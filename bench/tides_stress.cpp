@@ -0,0 +1,162 @@
+/**
+ * tides_stress: multithreaded render stress benchmark for the Tides core
+ *
+ * Renders a bank of generators split across 1..N threads, as Max does with
+ * parallel patchers or poly~ voices, and reports throughput and scaling.
+ * Every run is checked sample-for-sample against a single-threaded pass, so
+ * any shared state on the render path shows up as a mismatch.
+ *
+ * With --baseline, each thread count's wall ns per sample is written to a
+ * baseline file (tides_baseline.h); one sample per run, so repeat the run
+ * and pass every file to tides_compare.
+ *
+ * Usage: tides_stress [instances] [max_threads] [audio_seconds] [block_size] [--baseline file]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "tides_baseline.h"
+#include "tides_wrapper.h"
+
+namespace {
+
+const double kSampleRate = 48000.0;
+
+// Spread instances over all shape and smoothing regions
+struct InstanceParams {
+    float frequency;
+    float pw;
+    float shape;
+    float smoothness;
+    float shift;
+};
+
+InstanceParams ParamsFor(int index) {
+    InstanceParams p;
+    p.frequency = (float)((0.05 + (index % 97) * 0.37) / kSampleRate);
+    p.pw = 0.05f + 0.9f * (float)((index * 7) % 10) / 9.0f;
+    p.shape = (float)(index % 11) / 10.0f;
+    p.smoothness = (float)((index * 3) % 11) / 10.0f;
+    p.shift = (float)(index % 4) * 0.25f;
+    return p;
+}
+
+struct Worker {
+    std::vector<void*> generators;
+    std::vector<int> indices;
+    std::vector<double> block;
+    std::vector<double> checksums;
+};
+
+void RenderWorker(Worker* worker, long blocks, size_t block_size) {
+    for (size_t g = 0; g < worker->generators.size(); g++) {
+        worker->checksums[g] = 0.0;
+    }
+    for (long b = 0; b < blocks; b++) {
+        for (size_t g = 0; g < worker->generators.size(); g++) {
+            InstanceParams p = ParamsFor(worker->indices[g]);
+            tides_render_block(worker->generators[g], 1, 1, 1,
+                               p.frequency, p.pw, p.shape, p.smoothness, p.shift,
+                               0, worker->block.data(), block_size);
+            double sum = worker->checksums[g];
+            for (size_t i = 0; i < block_size; i++) {
+                sum += worker->block[i];
+            }
+            worker->checksums[g] = sum;
+        }
+    }
+}
+
+// Renders every instance on num_threads threads; returns wall seconds
+double Run(int instances, int num_threads, long blocks, size_t block_size,
+           std::vector<double>* checksums) {
+    std::vector<Worker> workers(num_threads);
+    for (int i = 0; i < instances; i++) {
+        Worker& w = workers[i % num_threads];
+        w.indices.push_back(i);
+    }
+    for (int t = 0; t < num_threads; t++) {
+        Worker& w = workers[t];
+        for (size_t g = 0; g < w.indices.size(); g++) {
+            w.generators.push_back(tides_create());
+        }
+        w.block.resize(block_size);
+        w.checksums.resize(w.indices.size());
+    }
+
+    std::vector<std::thread> threads;
+    auto start = std::chrono::steady_clock::now();
+    for (int t = 0; t < num_threads; t++) {
+        threads.push_back(std::thread(RenderWorker, &workers[t], blocks, block_size));
+    }
+    for (size_t t = 0; t < threads.size(); t++) {
+        threads[t].join();
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    checksums->assign(instances, 0.0);
+    for (int t = 0; t < num_threads; t++) {
+        Worker& w = workers[t];
+        for (size_t g = 0; g < w.indices.size(); g++) {
+            (*checksums)[w.indices[g]] = w.checksums[g];
+            tides_destroy(w.generators[g]);
+        }
+    }
+    return std::chrono::duration<double>(stop - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    tides_baseline::Baseline baseline("tides_stress", &argc, argv);
+    int instances = argc > 1 ? atoi(argv[1]) : 4096;
+    int max_threads = argc > 2 ? atoi(argv[2]) : (int)std::max(1u, std::thread::hardware_concurrency());
+    double audio_seconds = argc > 3 ? atof(argv[3]) : 1.0;
+    size_t block_size = argc > 4 ? (size_t)atoi(argv[4]) : 64;
+
+    if (instances < 1 || max_threads < 1 || audio_seconds <= 0.0 || block_size < 1) {
+        fprintf(stderr, "usage: tides_stress [instances] [max_threads] [audio_seconds] [block_size] [--baseline file]\n");
+        return 2;
+    }
+
+    long blocks = std::max(1L, (long)(audio_seconds * kSampleRate / block_size));
+    double samples = (double)instances * blocks * block_size;
+
+    printf("tides_stress: %d instances, %.2f s of audio at %.0f Hz, block %zu\n",
+           instances, audio_seconds, kSampleRate, block_size);
+    printf("%8s %12s %14s %10s %10s %8s\n",
+           "threads", "wall_s", "Msamples/s", "speedup", "efficiency", "match");
+
+    std::vector<double> reference;
+    double base_seconds = 0.0;
+    bool all_match = true;
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        std::vector<double> checksums;
+        double seconds = Run(instances, threads, blocks, block_size, &checksums);
+        if (threads == 1) {
+            reference = checksums;
+            base_seconds = seconds;
+        }
+        bool match = (checksums == reference);
+        all_match = all_match && match;
+
+        double speedup = base_seconds / seconds;
+        printf("%8d %12.3f %14.2f %10.2f %10.2f %8s\n",
+               threads, seconds, samples / seconds * 1e-6,
+               speedup, speedup / threads, match ? "yes" : "NO");
+        baseline.Add("threads/" + std::to_string(threads), "ns_per_sample", seconds * 1e9 / samples);
+
+        if (threads < max_threads && threads * 2 > max_threads) {
+            threads = max_threads / 2;  // Always finish with max_threads
+        }
+    }
+
+    return all_match && baseline.Write() ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+/**
+ * tides_vector: per-call cost of the Tides core at small vector sizes
+ *
+ * Feedback patches run the signal chain at vector size 1 or 4, where the cost
+ * of each call matters more than the cost of each sample. This renders one
+ * generator at vector sizes 1, 4, 16 and 64 through both entry points the Max
+ * external uses and reports nanoseconds per call and per sample:
+ *
+ *   block    tides_render_block, float parameters (no signal inlets)
+ *   signal   tides_render once per sample, parameters from signals
+ *
+ * Each figure is the fastest of several repetitions. With --baseline, every
+ * repetition's ns/sample is written to a baseline file (tides_baseline.h).
+ *
+ * Usage: tides_vector [samples_per_run] [--baseline file]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "tides_baseline.h"
+#include "tides_wrapper.h"
+
+namespace {
+
+const double kSampleRate = 48000.0;
+const int kRepetitions = 31;
+
+enum Path { kBlock, kSignal };
+
+// Signal inputs, laid out like the Max external's inlets
+struct Inputs {
+    std::vector<double> frequency;
+    std::vector<double> pw;
+    std::vector<double> shape;
+    std::vector<double> smoothness;
+    std::vector<double> shift;
+
+    explicit Inputs(size_t size)
+        : frequency(size), pw(size), shape(size), smoothness(size), shift(size) {
+        for (size_t i = 0; i < size; i++) {
+            frequency[i] = 2.0 + 0.1 * (double)(i % 7);  // Hz
+            pw[i] = 0.4;
+            shape[i] = 0.3;
+            smoothness[i] = 0.2;
+            shift[i] = 0.0;
+        }
+    }
+};
+
+void RenderCall(Path path, void* generator, const Inputs& in, double* out, size_t size) {
+    const double freq_coeff = 1.0 / kSampleRate;
+
+    switch (path) {
+        case kBlock:
+            tides_render_block(generator, 1, 1, 1, (float)(in.frequency[0] * freq_coeff),
+                               0.4f, 0.3f, 0.2f, 0.0f, 0, out, size);
+            break;
+        case kSignal:
+            for (size_t i = 0; i < size; i++) {
+                float sample[4];
+                float f = std::min((float)(in.frequency[i] * freq_coeff), 0.5f);
+                tides_render(generator, 1, 1, 1, f, (float)in.pw[i], (float)in.shape[i],
+                             (float)in.smoothness[i], (float)in.shift[i], 0, sample);
+                out[i] = (double)sample[0];
+            }
+            break;
+    }
+}
+
+// Fastest time per call over kRepetitions runs, in nanoseconds; every
+// repetition's time per call goes to times
+double TimeCalls(Path path, size_t size, long calls, std::vector<double>* times) {
+    void* generator = tides_create();
+    Inputs in(size);
+    std::vector<double> out(size);
+    double best = 0.0;
+
+    // Warm up caches and branch predictors
+    for (long c = 0; c < calls; c++) {
+        RenderCall(path, generator, in, out.data(), size);
+    }
+
+    for (int r = 0; r < kRepetitions; r++) {
+        auto start = std::chrono::steady_clock::now();
+        for (long c = 0; c < calls; c++) {
+            RenderCall(path, generator, in, out.data(), size);
+        }
+        auto stop = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(stop - start).count() / calls;
+        times->push_back(ns);
+        if (r == 0 || ns < best) {
+            best = ns;
+        }
+    }
+
+    tides_destroy(generator);
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    tides_baseline::Baseline baseline("tides_vector", &argc, argv);
+    long samples = argc > 1 ? atol(argv[1]) : 100000;
+
+    if (samples < 1) {
+        fprintf(stderr, "usage: tides_vector [samples_per_run] [--baseline file]\n");
+        return 2;
+    }
+
+    const size_t sizes[] = { 1, 4, 16, 64 };
+    const char* names[] = { "block", "signal" };
+
+    printf("tides_vector: %ld samples per run, best of %d runs\n", samples, kRepetitions);
+    printf("%10s %8s %12s %12s\n", "path", "vs", "ns/call", "ns/sample");
+
+    for (int path = kBlock; path <= kSignal; path++) {
+        for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+            long calls = std::max(1L, samples / (long)sizes[s]);
+            std::vector<double> times;
+            double ns = TimeCalls((Path)path, sizes[s], calls, &times);
+            printf("%10s %8zu %12.2f %12.2f\n", names[path], sizes[s], ns, ns / sizes[s]);
+
+            std::string config = std::string(names[path]) + "/" + std::to_string(sizes[s]);
+            for (size_t t = 0; t < times.size(); t++) {
+                baseline.Add(config, "ns_per_sample", times[t] / sizes[s]);
+            }
+        }
+    }
+
+    return baseline.Write() ? 0 : 1;
+}
@@ -0,0 +1,159 @@
+/**
+    @file
+    maxshim: stand-in for the Max SDK's ext.h
+
+    Declares the subset of the Max API used by tide~, with the same names and
+    signatures, so tide~.c compiles unchanged without a Max SDK checkout. The
+    implementation in maxshim.c keeps everything in-process; hosts drive it
+    through maxshim.h.
+*/
+
+#ifndef MAXSHIM_EXT_H
+#define MAXSHIM_EXT_H
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef long t_atom_long;
+typedef double t_atom_float;
+typedef long t_max_err;
+
+enum {
+    MAX_ERR_NONE = 0,
+    MAX_ERR_GENERIC = -1,
+    MAX_ERR_INVALID_PTR = -2
+};
+
+// Atom types, numbered as in the Max SDK
+enum {
+    A_NOTHING = 0,
+    A_LONG,
+    A_FLOAT,
+    A_SYM,
+    A_OBJ,
+    A_DEFLONG,
+    A_DEFFLOAT,
+    A_DEFSYM,
+    A_GIMME,
+    A_CANT
+};
+
+typedef struct _symbol
+{
+    const char* s_name;
+    void* s_thing;
+} t_symbol;
+
+typedef struct _class t_class;
+
+typedef struct _maxshim_outlet t_maxshim_outlet;
+
+// Object header. The fields are private to the shim, as in Max.
+typedef struct _object
+{
+    t_class* o_class;
+    long o_inlet;                   // Inlet of the message being handled (proxy_getinlet)
+    long o_outlets;                 // Outlets created with outlet_new
+    long o_signal_outlets;          // Those of them created as "signal"
+    t_maxshim_outlet* o_outlet_list;
+} t_object;
+
+typedef union word
+{
+    t_atom_long w_long;
+    t_atom_float w_float;
+    t_symbol* w_sym;
+    t_object* w_obj;
+} t_word;
+
+typedef struct atom
+{
+    short a_type;
+    t_word a_w;
+} t_atom;
+
+typedef void* (*method)(void*, ...);
+
+#define ASSIST_INLET 1
+#define ASSIST_OUTLET 2
+
+#define CLASS_BOX gensym("box")
+
+#define CLAMP(a, lo, hi) ( (a)>(lo)?( (a)<(hi)?(a):(hi) ):(lo) )
+
+#if defined(_MSC_VER)
+#define C74_EXPORT __declspec(dllexport)
+#else
+#define C74_EXPORT __attribute__((visibility("default")))
+#endif
+
+// Symbols and console
+t_symbol* gensym(const char* s);
+void post(const char* fmt, ...);
+
+// Classes and objects
+t_class* class_new(const char* name, method mnew, method mfree, long size, method mmenu, short type, ...);
+t_max_err class_addmethod(t_class* c, method m, const char* name, ...);
+t_max_err class_register(t_symbol* name_space, t_class* c);
+void* object_alloc(t_class* c);
+t_max_err object_free(void* x);
+void* object_method(void* x, t_symbol* s, ...);
+
+// Inlets, outlets and attributes
+long proxy_getinlet(t_object* master);
+void* outlet_new(void* x, const char* type);
+void* outlet_anything(void* o, t_symbol* s, short ac, t_atom* av);
+t_max_err attr_args_process(void* x, short ac, t_atom* av);
+
+// Atoms
+t_atom_float atom_getfloat(const t_atom* a);
+t_atom_long atom_getlong(const t_atom* a);
+t_symbol* atom_getsym(const t_atom* a);
+t_max_err atom_setlong(t_atom* a, t_atom_long b);
+t_max_err atom_setfloat(t_atom* a, double b);
+t_max_err atom_setsym(t_atom* a, t_symbol* b);
+
+// Scheduler time in milliseconds
+void clock_getftime(double* time);
+
+// Memory
+void* sysmem_newptrclear(long size);
+void sysmem_freeptr(void* ptr);
+
+// Paths: the shim's native style is POSIX, so conforming copies the name
+#define MAX_PATH_CHARS 2048
+
+enum {
+    PATH_STYLE_MAX = 0,
+    PATH_STYLE_NATIVE,
+    PATH_STYLE_COLON,
+    PATH_STYLE_SLASH,
+    PATH_STYLE_NATIVE_WIN
+};
+
+enum {
+    PATH_TYPE_IGNORE = 0,
+    PATH_TYPE_ABSOLUTE,
+    PATH_TYPE_RELATIVE,
+    PATH_TYPE_BOOT
+};
+
+short path_nameconform(const char* src, char* dst, long style, long type);
+
+// Functions run when the application quits (maxshim_quit in hosts)
+void quittask_install(method m, void* a);
+void quittask_remove(method m);
+
+// Entry point every external defines
+C74_EXPORT void ext_main(void* r);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSHIM_EXT_H
@@ -0,0 +1,45 @@
+/**
+    @file
+    maxshim: stand-in for the Max SDK's ext_dictobj.h and ext_dictionary.h
+
+    Dictionaries of named values, and the registry that lets them travel
+    between objects as "dictionary <name>" messages. Each key holds one or
+    more atoms; appending to an existing key replaces its value. Registered
+    dictionaries are reference counted: dictobj_register returns the caller's
+    reference, dictobj_findregistered_retain adds one, dictobj_release drops
+    one and frees the dictionary with the last.
+*/
+
+#ifndef MAXSHIM_EXT_DICTOBJ_H
+#define MAXSHIM_EXT_DICTOBJ_H
+
+#include "ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _dictionary t_dictionary;
+
+t_dictionary* dictionary_new(void);
+t_max_err dictionary_appendlong(t_dictionary* d, t_symbol* key, t_atom_long value);
+t_max_err dictionary_appendfloat(t_dictionary* d, t_symbol* key, double value);
+t_max_err dictionary_appendsym(t_dictionary* d, t_symbol* key, t_symbol* value);
+t_max_err dictionary_appendatoms(t_dictionary* d, t_symbol* key, long argc, t_atom* argv);
+
+t_max_err dictionary_getlong(const t_dictionary* d, t_symbol* key, t_atom_long* value);
+t_max_err dictionary_getfloat(const t_dictionary* d, t_symbol* key, double* value);
+t_max_err dictionary_getsym(const t_dictionary* d, t_symbol* key, t_symbol** value);
+t_max_err dictionary_getatoms(const t_dictionary* d, t_symbol* key, long* argc, t_atom** argv);
+t_max_err dictionary_getkeys(const t_dictionary* d, long* numkeys, t_symbol*** keys);
+void dictionary_freekeys(t_dictionary* d, long numkeys, t_symbol** keys);
+
+t_dictionary* dictobj_register(t_dictionary* d, t_symbol** name);
+t_max_err dictobj_release(t_dictionary* d);
+t_dictionary* dictobj_findregistered_retain(t_symbol* name);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSHIM_EXT_DICTOBJ_H
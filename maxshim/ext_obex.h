@@ -0,0 +1,45 @@
+/**
+    @file
+    maxshim: stand-in for the Max SDK's ext_obex.h
+
+    Class attributes. Double attributes are stored at their struct offset and
+    set from @name arguments by attr_args_process, through the custom setter
+    when one is given and clamped to the filter range otherwise. Labels, save
+    flags and defaults are accepted and ignored.
+*/
+
+#ifndef MAXSHIM_EXT_OBEX_H
+#define MAXSHIM_EXT_OBEX_H
+
+#include "ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+t_max_err maxshim_class_attr_double(t_class* c, const char* name, long offset);
+t_max_err maxshim_class_attr_accessors(t_class* c, const char* name, method getter, method setter);
+t_max_err maxshim_class_attr_filter_min(t_class* c, const char* name, double min);
+t_max_err maxshim_class_attr_filter_max(t_class* c, const char* name, double max);
+
+#define CLASS_ATTR_DOUBLE(c, attrname, flags, structname, structmember) \
+    maxshim_class_attr_double((c), (attrname), (long)offsetof(structname, structmember))
+
+#define CLASS_ATTR_ACCESSORS(c, attrname, getter, setter) \
+    maxshim_class_attr_accessors((c), (attrname), (method)(getter), (method)(setter))
+
+#define CLASS_ATTR_FILTER_MIN(c, attrname, minval) \
+    maxshim_class_attr_filter_min((c), (attrname), (double)(minval))
+
+#define CLASS_ATTR_FILTER_MAX(c, attrname, maxval) \
+    maxshim_class_attr_filter_max((c), (attrname), (double)(maxval))
+
+#define CLASS_ATTR_DEFAULT(c, attrname, flags, parsestr) ((void)0)
+#define CLASS_ATTR_LABEL(c, attrname, flags, labelstr) ((void)0)
+#define CLASS_ATTR_SAVE(c, attrname, flags) ((void)0)
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSHIM_EXT_OBEX_H
@@ -0,0 +1,28 @@
+/**
+    @file
+    maxshim: stand-in for the Max SDK's ext_systhread.h
+
+    Threads for work that must stay off the main and audio threads. The shim
+    maps them onto pthreads; priority and flags are accepted and ignored.
+*/
+
+#ifndef MAXSHIM_EXT_SYSTHREAD_H
+#define MAXSHIM_EXT_SYSTHREAD_H
+
+#include "ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef void* t_systhread;
+
+long systhread_create(method entryproc, void* arg, long stacksize, long priority, long flags, t_systhread* thread);
+long systhread_join(t_systhread thread, unsigned int* retval);
+void systhread_sleep(long milliseconds);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSHIM_EXT_SYSTHREAD_H
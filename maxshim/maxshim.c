@@ -0,0 +1,1174 @@
+/**
+    @file
+    maxshim: in-process implementation of the Max API subset in ext.h,
+    ext_obex.h, ext_dictobj.h, ext_systhread.h and z_dsp.h, plus the host
+    interface in maxshim.h
+*/
+
+#include "maxshim.h"
+
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define MAXSHIM_MAX_CLASSES 16
+#define MAXSHIM_MAX_METHODS 32
+#define MAXSHIM_MAX_ATTRS 16
+#define MAXSHIM_MAX_ROUTINES 8
+#define MAXSHIM_SYMBOL_BUCKETS 256
+#define MAXSHIM_POST_LENGTH 1024
+#define MAXSHIM_MAX_QUITTASKS 16
+
+typedef struct _maxshim_method
+{
+    t_symbol* name;
+    method fn;
+    short type;                     // First argument type, A_NOTHING when none
+} t_maxshim_method;
+
+typedef struct _maxshim_attr
+{
+    t_symbol* name;
+    long offset;                    // Offset of the double in the object struct
+    method getter;
+    method setter;
+    double min;
+    double max;
+    int has_min;
+    int has_max;
+} t_maxshim_attr;
+
+struct _class
+{
+    t_symbol* name;
+    method mnew;
+    method mfree;
+    long size;
+    short new_type;
+    int registered;
+    int dsp;
+    t_maxshim_method methods[MAXSHIM_MAX_METHODS];
+    int num_methods;
+    t_maxshim_attr attrs[MAXSHIM_MAX_ATTRS];
+    int num_attrs;
+};
+
+typedef struct _maxshim_routine
+{
+    t_object* x;
+    t_perfroutine64 perform;
+    long flags;
+    void* userparam;
+} t_maxshim_routine;
+
+struct _maxshim_dsp
+{
+    t_object ob;                    // Receives dsp_add64 from the dsp64 method
+    t_object* x;
+    short* count;
+    long numins;
+    long numouts;
+    t_maxshim_routine routines[MAXSHIM_MAX_ROUTINES];
+    long num_routines;
+};
+
+struct _maxshim_outlet
+{
+    t_object* owner;
+    long order;                     // Creation order; Max adds each new outlet on the left
+    t_maxshim_outlet* next;
+};
+
+typedef struct _maxshim_entry
+{
+    t_symbol* key;
+    long argc;
+    t_atom* argv;
+} t_maxshim_entry;
+
+struct _dictionary
+{
+    t_object ob;
+    t_maxshim_entry* entries;
+    long num_entries;
+    long capacity;
+    t_symbol* name;                 // Set while registered
+    long refcount;
+    t_dictionary* next;             // Registry list
+};
+
+typedef struct _maxshim_symbol_entry
+{
+    t_symbol sym;
+    struct _maxshim_symbol_entry* next;
+} t_maxshim_symbol_entry;
+
+static t_class maxshim_classes[MAXSHIM_MAX_CLASSES];
+static int maxshim_num_classes = 0;
+static t_class* maxshim_chain_class = NULL;
+
+static t_maxshim_symbol_entry* maxshim_symbols[MAXSHIM_SYMBOL_BUCKETS];
+static pthread_mutex_t maxshim_symbol_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static _Atomic double maxshim_time = 0.0;
+
+static t_maxshim_post_hook maxshim_post_hook = NULL;
+static void* maxshim_post_context = NULL;
+static t_maxshim_outlet_hook maxshim_outlet_hook = NULL;
+static void* maxshim_outlet_context = NULL;
+
+static t_class* maxshim_dictionary_class = NULL;
+static t_dictionary* maxshim_registry = NULL;
+static long maxshim_registry_serial = 0;
+static pthread_mutex_t maxshim_registry_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+typedef struct _maxshim_quittask
+{
+    method fn;
+    void* arg;
+} t_maxshim_quittask;
+
+static t_maxshim_quittask maxshim_quittasks[MAXSHIM_MAX_QUITTASKS];
+static int maxshim_num_quittasks = 0;
+
+// Internal helpers
+t_maxshim_method* maxshim_find_method(t_class* c, t_symbol* name);
+t_maxshim_attr* maxshim_find_attr(t_class* c, t_symbol* name);
+t_max_err maxshim_attr_apply(t_object* x, t_maxshim_attr* attr, long argc, t_atom* argv);
+t_max_err maxshim_dsp_add64(t_maxshim_dsp* dsp, t_object* x, t_perfroutine64 perform, long flags, void* userparam);
+void maxshim_dictionary_free(t_dictionary* d);
+t_maxshim_entry* maxshim_dictionary_find(const t_dictionary* d, t_symbol* key);
+t_max_err maxshim_dictionary_set(t_dictionary* d, t_symbol* key, long argc, const t_atom* argv);
+
+//----------------------------------------------------------------------------------------------
+
+t_symbol* gensym(const char* s)
+{
+    unsigned int hash = 5381;
+    for (const char* p = s; *p; p++) {
+        hash = hash * 33 + (unsigned char)*p;
+    }
+    hash &= MAXSHIM_SYMBOL_BUCKETS - 1;
+
+    pthread_mutex_lock(&maxshim_symbol_mutex);
+
+    t_maxshim_symbol_entry* entry = maxshim_symbols[hash];
+    while (entry && strcmp(entry->sym.s_name, s) != 0) {
+        entry = entry->next;
+    }
+
+    if (!entry) {
+        // Symbols live for the whole process, as in Max
+        size_t length = strlen(s) + 1;
+        entry = (t_maxshim_symbol_entry*)malloc(sizeof(t_maxshim_symbol_entry) + length);
+        if (entry) {
+            char* name = (char*)(entry + 1);
+            memcpy(name, s, length);
+            entry->sym.s_name = name;
+            entry->sym.s_thing = NULL;
+            entry->next = maxshim_symbols[hash];
+            maxshim_symbols[hash] = entry;
+        }
+    }
+
+    pthread_mutex_unlock(&maxshim_symbol_mutex);
+    return entry ? &entry->sym : NULL;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void post(const char* fmt, ...)
+{
+    char line[MAXSHIM_POST_LENGTH];
+    va_list args;
+
+    va_start(args, fmt);
+    vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    if (maxshim_post_hook) {
+        maxshim_post_hook(line, maxshim_post_context);
+    }
+    else {
+        fprintf(stderr, "%s\n", line);
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_class* class_new(const char* name, method mnew, method mfree, long size, method mmenu, short type, ...)
+{
+    if (maxshim_num_classes >= MAXSHIM_MAX_CLASSES) {
+        post("maxshim: too many classes, %s not created", name);
+        return NULL;
+    }
+
+    t_class* c = &maxshim_classes[maxshim_num_classes++];
+    memset(c, 0, sizeof(t_class));
+    c->name = gensym(name);
+    c->mnew = mnew;
+    c->mfree = mfree;
+    c->size = size;
+    c->new_type = type;
+    return c;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err class_addmethod(t_class* c, method m, const char* name, ...)
+{
+    if (!c || c->num_methods >= MAXSHIM_MAX_METHODS) {
+        return MAX_ERR_GENERIC;
+    }
+
+    va_list args;
+    va_start(args, name);
+    int type = va_arg(args, int);
+    va_end(args);
+
+    t_maxshim_method* entry = &c->methods[c->num_methods++];
+    entry->name = gensym(name);
+    entry->fn = m;
+    entry->type = (short)type;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err class_register(t_symbol* name_space, t_class* c)
+{
+    if (!c) {
+        return MAX_ERR_INVALID_PTR;
+    }
+    c->registered = 1;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void class_dspinit(t_class* c)
+{
+    if (c) {
+        c->dsp = 1;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+void* object_alloc(t_class* c)
+{
+    if (!c || c->size < (long)sizeof(t_object)) {
+        return NULL;
+    }
+
+    t_object* x = (t_object*)calloc(1, (size_t)c->size);
+    if (x) {
+        x->o_class = c;
+    }
+    return x;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err object_free(void* x)
+{
+    if (!x) {
+        return MAX_ERR_INVALID_PTR;
+    }
+
+    t_object* ob = (t_object*)x;
+    if (ob->o_class && ob->o_class->mfree) {
+        ((void (*)(void*))ob->o_class->mfree)(x);
+    }
+    while (ob->o_outlet_list) {
+        t_maxshim_outlet* outlet = ob->o_outlet_list;
+        ob->o_outlet_list = outlet->next;
+        free(outlet);
+    }
+    free(x);
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void* object_method(void* x, t_symbol* s, ...)
+{
+    // A_CANT methods receive up to four pointer-sized arguments, enough for
+    // the messages the shim sends and receives (dsp64 is called directly)
+    t_object* ob = (t_object*)x;
+    if (!ob || !ob->o_class) {
+        return NULL;
+    }
+
+    t_maxshim_method* m = maxshim_find_method(ob->o_class, s);
+    if (!m) {
+        return NULL;
+    }
+
+    va_list args;
+    va_start(args, s);
+    void* a0 = va_arg(args, void*);
+    void* a1 = va_arg(args, void*);
+    void* a2 = va_arg(args, void*);
+    void* a3 = va_arg(args, void*);
+    va_end(args);
+
+    return ((void* (*)(void*, void*, void*, void*, void*))m->fn)(x, a0, a1, a2, a3);
+}
+
+//----------------------------------------------------------------------------------------------
+
+long proxy_getinlet(t_object* master)
+{
+    return master ? master->o_inlet : 0;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void* outlet_new(void* x, const char* type)
+{
+    t_object* ob = (t_object*)x;
+    t_maxshim_outlet* outlet = (t_maxshim_outlet*)malloc(sizeof(t_maxshim_outlet));
+    if (!outlet) {
+        return NULL;
+    }
+
+    outlet->owner = ob;
+    outlet->order = ob->o_outlets++;
+    outlet->next = ob->o_outlet_list;
+    ob->o_outlet_list = outlet;
+    if (type && strcmp(type, "signal") == 0) {
+        ob->o_signal_outlets++;
+    }
+    return outlet;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void* outlet_anything(void* o, t_symbol* s, short ac, t_atom* av)
+{
+    t_maxshim_outlet* outlet = (t_maxshim_outlet*)o;
+    if (outlet && maxshim_outlet_hook) {
+        long index = outlet->owner->o_outlets - 1 - outlet->order;
+        maxshim_outlet_hook(outlet->owner, index, s, ac, av, maxshim_outlet_context);
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err attr_args_process(void* x, short ac, t_atom* av)
+{
+    // Apply "@name value..." pairs found anywhere in the arguments
+    t_object* ob = (t_object*)x;
+
+    for (short i = 0; i < ac; i++) {
+        if (av[i].a_type != A_SYM || av[i].a_w.w_sym->s_name[0] != '@') {
+            continue;
+        }
+
+        short first = i + 1;
+        short last = first;
+        while (last < ac && !(av[last].a_type == A_SYM && av[last].a_w.w_sym->s_name[0] == '@')) {
+            last++;
+        }
+
+        t_maxshim_attr* attr = maxshim_find_attr(ob->o_class, gensym(av[i].a_w.w_sym->s_name + 1));
+        if (!attr) {
+            post("%s: doesn't understand attribute %s", ob->o_class->name->s_name, av[i].a_w.w_sym->s_name + 1);
+        }
+        else if (last > first) {
+            maxshim_attr_apply(ob, attr, last - first, av + first);
+        }
+        i = last - 1;
+    }
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_atom_float atom_getfloat(const t_atom* a)
+{
+    if (!a) {
+        return 0.0;
+    }
+    switch (a->a_type) {
+        case A_FLOAT: return a->a_w.w_float;
+        case A_LONG: return (t_atom_float)a->a_w.w_long;
+        default: return 0.0;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_atom_long atom_getlong(const t_atom* a)
+{
+    if (!a) {
+        return 0;
+    }
+    switch (a->a_type) {
+        case A_FLOAT: return (t_atom_long)a->a_w.w_float;
+        case A_LONG: return a->a_w.w_long;
+        default: return 0;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_symbol* atom_getsym(const t_atom* a)
+{
+    // Max returns the empty symbol for non-symbol atoms
+    return (a && a->a_type == A_SYM) ? a->a_w.w_sym : gensym("");
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err atom_setlong(t_atom* a, t_atom_long b)
+{
+    if (!a) {
+        return MAX_ERR_INVALID_PTR;
+    }
+    a->a_type = A_LONG;
+    a->a_w.w_long = b;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err atom_setfloat(t_atom* a, double b)
+{
+    if (!a) {
+        return MAX_ERR_INVALID_PTR;
+    }
+    a->a_type = A_FLOAT;
+    a->a_w.w_float = b;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err atom_setsym(t_atom* a, t_symbol* b)
+{
+    if (!a) {
+        return MAX_ERR_INVALID_PTR;
+    }
+    a->a_type = A_SYM;
+    a->a_w.w_sym = b;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void clock_getftime(double* time)
+{
+    *time = atomic_load_explicit(&maxshim_time, memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------------------
+
+void* sysmem_newptrclear(long size)
+{
+    return calloc(1, (size_t)size);
+}
+
+//----------------------------------------------------------------------------------------------
+
+void sysmem_freeptr(void* ptr)
+{
+    free(ptr);
+}
+
+//----------------------------------------------------------------------------------------------
+
+short path_nameconform(const char* src, char* dst, long style, long type)
+{
+    if (!src || !dst || strlen(src) >= MAX_PATH_CHARS) {
+        return 1;
+    }
+    strcpy(dst, src);
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void quittask_install(method m, void* a)
+{
+    if (maxshim_num_quittasks < MAXSHIM_MAX_QUITTASKS) {
+        maxshim_quittasks[maxshim_num_quittasks].fn = m;
+        maxshim_quittasks[maxshim_num_quittasks].arg = a;
+        maxshim_num_quittasks++;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+void quittask_remove(method m)
+{
+    for (int i = 0; i < maxshim_num_quittasks; i++) {
+        if (maxshim_quittasks[i].fn == m) {
+            memmove(&maxshim_quittasks[i], &maxshim_quittasks[i + 1],
+                    (size_t)(maxshim_num_quittasks - i - 1) * sizeof(t_maxshim_quittask));
+            maxshim_num_quittasks--;
+            return;
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+long systhread_create(method entryproc, void* arg, long stacksize, long priority, long flags, t_systhread* thread)
+{
+    pthread_t* handle = (pthread_t*)malloc(sizeof(pthread_t));
+    if (!handle || !thread) {
+        free(handle);
+        return 1;
+    }
+    if (pthread_create(handle, NULL, (void* (*)(void*))entryproc, arg) != 0) {
+        free(handle);
+        return 1;
+    }
+    *thread = handle;
+    return 0;
+}
+
+//----------------------------------------------------------------------------------------------
+
+long systhread_join(t_systhread thread, unsigned int* retval)
+{
+    pthread_t* handle = (pthread_t*)thread;
+    void* result = NULL;
+    if (!handle) {
+        return 1;
+    }
+    int err = pthread_join(*handle, &result);
+    free(handle);
+    if (retval) {
+        *retval = (unsigned int)(uintptr_t)result;
+    }
+    return err ? 1 : 0;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void systhread_sleep(long milliseconds)
+{
+    struct timespec delay;
+    delay.tv_sec = milliseconds / 1000;
+    delay.tv_nsec = (milliseconds % 1000) * 1000000L;
+    nanosleep(&delay, NULL);
+}
+
+//----------------------------------------------------------------------------------------------
+
+void dsp_setup(t_pxobject* x, long nsignals)
+{
+    x->z_in = nsignals;
+    x->z_disabled = 0;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void dsp_free(t_pxobject* x)
+{
+    // Inlets and proxies own no memory in the shim
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_dictionary* dictionary_new(void)
+{
+    pthread_mutex_lock(&maxshim_registry_mutex);
+    if (!maxshim_dictionary_class) {
+        maxshim_dictionary_class = class_new("dictionary", NULL, (method)maxshim_dictionary_free,
+                                             (long)sizeof(t_dictionary), NULL, A_NOTHING, 0);
+    }
+    pthread_mutex_unlock(&maxshim_registry_mutex);
+
+    return (t_dictionary*)object_alloc(maxshim_dictionary_class);
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_appendlong(t_dictionary* d, t_symbol* key, t_atom_long value)
+{
+    t_atom a;
+    atom_setlong(&a, value);
+    return maxshim_dictionary_set(d, key, 1, &a);
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_appendfloat(t_dictionary* d, t_symbol* key, double value)
+{
+    t_atom a;
+    atom_setfloat(&a, value);
+    return maxshim_dictionary_set(d, key, 1, &a);
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_appendsym(t_dictionary* d, t_symbol* key, t_symbol* value)
+{
+    t_atom a;
+    atom_setsym(&a, value);
+    return maxshim_dictionary_set(d, key, 1, &a);
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_appendatoms(t_dictionary* d, t_symbol* key, long argc, t_atom* argv)
+{
+    return maxshim_dictionary_set(d, key, argc, argv);
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_getlong(const t_dictionary* d, t_symbol* key, t_atom_long* value)
+{
+    t_maxshim_entry* entry = maxshim_dictionary_find(d, key);
+    if (!entry || entry->argc < 1 || !value) {
+        return MAX_ERR_GENERIC;
+    }
+    *value = atom_getlong(entry->argv);
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_getfloat(const t_dictionary* d, t_symbol* key, double* value)
+{
+    t_maxshim_entry* entry = maxshim_dictionary_find(d, key);
+    if (!entry || entry->argc < 1 || !value) {
+        return MAX_ERR_GENERIC;
+    }
+    *value = atom_getfloat(entry->argv);
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_getsym(const t_dictionary* d, t_symbol* key, t_symbol** value)
+{
+    t_maxshim_entry* entry = maxshim_dictionary_find(d, key);
+    if (!entry || entry->argc < 1 || entry->argv[0].a_type != A_SYM || !value) {
+        return MAX_ERR_GENERIC;
+    }
+    *value = entry->argv[0].a_w.w_sym;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_getatoms(const t_dictionary* d, t_symbol* key, long* argc, t_atom** argv)
+{
+    // The atoms stay owned by the dictionary
+    t_maxshim_entry* entry = maxshim_dictionary_find(d, key);
+    if (!entry || !argc || !argv) {
+        return MAX_ERR_GENERIC;
+    }
+    *argc = entry->argc;
+    *argv = entry->argv;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictionary_getkeys(const t_dictionary* d, long* numkeys, t_symbol*** keys)
+{
+    if (!d || !numkeys || !keys) {
+        return MAX_ERR_INVALID_PTR;
+    }
+
+    *numkeys = d->num_entries;
+    *keys = (t_symbol**)malloc((size_t)(d->num_entries + 1) * sizeof(t_symbol*));
+    if (!*keys) {
+        return MAX_ERR_GENERIC;
+    }
+    for (long i = 0; i < d->num_entries; i++) {
+        (*keys)[i] = d->entries[i].key;
+    }
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void dictionary_freekeys(t_dictionary* d, long numkeys, t_symbol** keys)
+{
+    free(keys);
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_dictionary* dictobj_register(t_dictionary* d, t_symbol** name)
+{
+    if (!d || !name) {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&maxshim_registry_mutex);
+    if (!d->name) {
+        if (!*name) {
+            char unique[32];
+            snprintf(unique, sizeof(unique), "u%09ld", ++maxshim_registry_serial);
+            *name = gensym(unique);
+        }
+        d->name = *name;
+        d->refcount = 1;
+        d->next = maxshim_registry;
+        maxshim_registry = d;
+    }
+    else {
+        *name = d->name;
+    }
+    pthread_mutex_unlock(&maxshim_registry_mutex);
+    return d;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err dictobj_release(t_dictionary* d)
+{
+    if (!d) {
+        return MAX_ERR_INVALID_PTR;
+    }
+
+    int last = 0;
+    pthread_mutex_lock(&maxshim_registry_mutex);
+    if (d->name && --d->refcount == 0) {
+        t_dictionary** link = &maxshim_registry;
+        while (*link && *link != d) {
+            link = &(*link)->next;
+        }
+        if (*link) {
+            *link = d->next;
+        }
+        last = 1;
+    }
+    pthread_mutex_unlock(&maxshim_registry_mutex);
+
+    if (last) {
+        object_free(d);
+    }
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_dictionary* dictobj_findregistered_retain(t_symbol* name)
+{
+    pthread_mutex_lock(&maxshim_registry_mutex);
+    t_dictionary* d = maxshim_registry;
+    while (d && d->name != name) {
+        d = d->next;
+    }
+    if (d) {
+        d->refcount++;
+    }
+    pthread_mutex_unlock(&maxshim_registry_mutex);
+    return d;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_class_attr_double(t_class* c, const char* name, long offset)
+{
+    if (!c || c->num_attrs >= MAXSHIM_MAX_ATTRS) {
+        return MAX_ERR_GENERIC;
+    }
+
+    t_maxshim_attr* attr = &c->attrs[c->num_attrs++];
+    memset(attr, 0, sizeof(t_maxshim_attr));
+    attr->name = gensym(name);
+    attr->offset = offset;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_class_attr_accessors(t_class* c, const char* name, method getter, method setter)
+{
+    t_maxshim_attr* attr = maxshim_find_attr(c, gensym(name));
+    if (!attr) {
+        return MAX_ERR_GENERIC;
+    }
+    attr->getter = getter;
+    attr->setter = setter;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_class_attr_filter_min(t_class* c, const char* name, double min)
+{
+    t_maxshim_attr* attr = maxshim_find_attr(c, gensym(name));
+    if (!attr) {
+        return MAX_ERR_GENERIC;
+    }
+    attr->min = min;
+    attr->has_min = 1;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_class_attr_filter_max(t_class* c, const char* name, double max)
+{
+    t_maxshim_attr* attr = maxshim_find_attr(c, gensym(name));
+    if (!attr) {
+        return MAX_ERR_GENERIC;
+    }
+    attr->max = max;
+    attr->has_max = 1;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void* maxshim_new(const char* classname, long argc, t_atom* argv)
+{
+    t_symbol* name = gensym(classname);
+
+    for (int i = 0; i < maxshim_num_classes; i++) {
+        t_class* c = &maxshim_classes[i];
+        if (c->name != name || !c->registered || !c->mnew) {
+            continue;
+        }
+        if (c->new_type == A_GIMME) {
+            return ((void* (*)(t_symbol*, long, t_atom*))c->mnew)(name, argc, argv);
+        }
+        return ((void* (*)(void))c->mnew)();
+    }
+
+    post("maxshim: no class named %s (was its ext_main called?)", classname);
+    return NULL;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void maxshim_free(void* x)
+{
+    object_free(x);
+}
+
+//----------------------------------------------------------------------------------------------
+
+long maxshim_numinlets(void* x)
+{
+    t_object* ob = (t_object*)x;
+    return (ob && ob->o_class->dsp) ? ((t_pxobject*)x)->z_in : 0;
+}
+
+//----------------------------------------------------------------------------------------------
+
+long maxshim_numoutlets(void* x)
+{
+    return x ? ((t_object*)x)->o_outlets : 0;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_float(void* x, long inlet, double f)
+{
+    t_object* ob = (t_object*)x;
+    t_maxshim_method* m = ob ? maxshim_find_method(ob->o_class, gensym("float")) : NULL;
+    if (!m) {
+        return MAX_ERR_GENERIC;
+    }
+
+    ob->o_inlet = inlet;
+    ((void (*)(void*, double))m->fn)(x, f);
+    ob->o_inlet = 0;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_bang(void* x, long inlet)
+{
+    t_object* ob = (t_object*)x;
+    t_maxshim_method* m = ob ? maxshim_find_method(ob->o_class, gensym("bang")) : NULL;
+    if (!m) {
+        return MAX_ERR_GENERIC;
+    }
+
+    ob->o_inlet = inlet;
+    ((void (*)(void*))m->fn)(x);
+    ob->o_inlet = 0;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_message(void* x, long inlet, const char* selector, long argc, t_atom* argv)
+{
+    t_symbol* s = gensym(selector);
+    t_object* ob = (t_object*)x;
+    t_maxshim_method* m = ob ? maxshim_find_method(ob->o_class, s) : NULL;
+    if (!m || m->type != A_GIMME) {
+        return MAX_ERR_GENERIC;
+    }
+
+    ob->o_inlet = inlet;
+    ((void (*)(void*, t_symbol*, long, t_atom*))m->fn)(x, s, argc, argv);
+    ob->o_inlet = 0;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_attr_setfloat(void* x, const char* name, double value)
+{
+    t_object* ob = (t_object*)x;
+    t_maxshim_attr* attr = ob ? maxshim_find_attr(ob->o_class, gensym(name)) : NULL;
+    if (!attr) {
+        return MAX_ERR_GENERIC;
+    }
+
+    t_atom a;
+    atom_setfloat(&a, value);
+    return maxshim_attr_apply(ob, attr, 1, &a);
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_attr_getfloat(void* x, const char* name, double* value)
+{
+    t_object* ob = (t_object*)x;
+    t_maxshim_attr* attr = ob ? maxshim_find_attr(ob->o_class, gensym(name)) : NULL;
+    if (!attr || !value) {
+        return MAX_ERR_GENERIC;
+    }
+
+    memcpy(value, (char*)x + attr->offset, sizeof(double));
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_maxshim_dsp* maxshim_dsp_new(void* x, const short* count, double samplerate, long maxvectorsize)
+{
+    t_object* ob = (t_object*)x;
+    t_maxshim_method* m = ob ? maxshim_find_method(ob->o_class, gensym("dsp64")) : NULL;
+    if (!m) {
+        return NULL;
+    }
+
+    if (!maxshim_chain_class) {
+        maxshim_chain_class = class_new("maxshim.dspchain", NULL, NULL, (long)sizeof(t_maxshim_dsp), NULL, A_NOTHING, 0);
+        class_addmethod(maxshim_chain_class, (method)maxshim_dsp_add64, "dsp_add64", A_CANT, 0);
+    }
+
+    t_maxshim_dsp* dsp = (t_maxshim_dsp*)calloc(1, sizeof(t_maxshim_dsp));
+    if (!dsp) {
+        return NULL;
+    }
+
+    dsp->ob.o_class = maxshim_chain_class;
+    dsp->x = ob;
+    dsp->numins = maxshim_numinlets(x);
+    dsp->numouts = ob->o_signal_outlets;
+    dsp->count = (short*)calloc((size_t)(dsp->numins + dsp->numouts + 1), sizeof(short));
+    if (!dsp->count) {
+        free(dsp);
+        return NULL;
+    }
+    if (count) {
+        memcpy(dsp->count, count, (size_t)(dsp->numins + dsp->numouts) * sizeof(short));
+    }
+
+    ((void (*)(void*, t_object*, short*, double, long, long))m->fn)(x, &dsp->ob, dsp->count, samplerate, maxvectorsize, 0);
+    return dsp;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void maxshim_dsp_free(t_maxshim_dsp* dsp)
+{
+    if (dsp) {
+        free(dsp->count);
+        free(dsp);
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+long maxshim_dsp_routines(const t_maxshim_dsp* dsp)
+{
+    return dsp ? dsp->num_routines : 0;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void maxshim_dsp_tick(t_maxshim_dsp* dsp, double** ins, double** outs, long sampleframes)
+{
+    for (long i = 0; i < dsp->num_routines; i++) {
+        t_maxshim_routine* r = &dsp->routines[i];
+        r->perform(r->x, &dsp->ob, ins, dsp->numins, outs, dsp->numouts, sampleframes, r->flags, r->userparam);
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+void maxshim_settime(double ms)
+{
+    atomic_store_explicit(&maxshim_time, ms, memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------------------
+
+double maxshim_gettime(void)
+{
+    return atomic_load_explicit(&maxshim_time, memory_order_relaxed);
+}
+
+//----------------------------------------------------------------------------------------------
+
+void maxshim_quit(void)
+{
+    while (maxshim_num_quittasks > 0) {
+        t_maxshim_quittask task = maxshim_quittasks[--maxshim_num_quittasks];
+        task.fn(task.arg);
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+void maxshim_set_post_hook(t_maxshim_post_hook hook, void* context)
+{
+    maxshim_post_hook = hook;
+    maxshim_post_context = context;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void maxshim_set_outlet_hook(t_maxshim_outlet_hook hook, void* context)
+{
+    maxshim_outlet_hook = hook;
+    maxshim_outlet_context = context;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_maxshim_method* maxshim_find_method(t_class* c, t_symbol* name)
+{
+    for (int i = 0; c && i < c->num_methods; i++) {
+        if (c->methods[i].name == name) {
+            return &c->methods[i];
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_maxshim_attr* maxshim_find_attr(t_class* c, t_symbol* name)
+{
+    for (int i = 0; c && i < c->num_attrs; i++) {
+        if (c->attrs[i].name == name) {
+            return &c->attrs[i];
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_attr_apply(t_object* x, t_maxshim_attr* attr, long argc, t_atom* argv)
+{
+    // Filters first, then the class's setter or a plain store
+    t_atom value;
+    double f = atom_getfloat(argv);
+
+    if (attr->has_min && f < attr->min) {
+        f = attr->min;
+    }
+    if (attr->has_max && f > attr->max) {
+        f = attr->max;
+    }
+    atom_setfloat(&value, f);
+
+    if (attr->setter) {
+        return ((t_max_err (*)(void*, void*, long, t_atom*))attr->setter)(x, attr, 1, &value);
+    }
+    memcpy((char*)x + attr->offset, &f, sizeof(double));
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_dsp_add64(t_maxshim_dsp* dsp, t_object* x, t_perfroutine64 perform, long flags, void* userparam)
+{
+    if (dsp->num_routines >= MAXSHIM_MAX_ROUTINES) {
+        post("maxshim: too many perform routines");
+        return MAX_ERR_GENERIC;
+    }
+
+    t_maxshim_routine* r = &dsp->routines[dsp->num_routines++];
+    r->x = x;
+    r->perform = perform;
+    r->flags = flags;
+    r->userparam = userparam;
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void maxshim_dictionary_free(t_dictionary* d)
+{
+    for (long i = 0; i < d->num_entries; i++) {
+        free(d->entries[i].argv);
+    }
+    free(d->entries);
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_maxshim_entry* maxshim_dictionary_find(const t_dictionary* d, t_symbol* key)
+{
+    for (long i = 0; d && i < d->num_entries; i++) {
+        if (d->entries[i].key == key) {
+            return &d->entries[i];
+        }
+    }
+    return NULL;
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_max_err maxshim_dictionary_set(t_dictionary* d, t_symbol* key, long argc, const t_atom* argv)
+{
+    if (!d || !key || argc < 0 || (argc && !argv)) {
+        return MAX_ERR_INVALID_PTR;
+    }
+
+    t_atom* copy = (t_atom*)malloc((size_t)(argc ? argc : 1) * sizeof(t_atom));
+    if (!copy) {
+        return MAX_ERR_GENERIC;
+    }
+    memcpy(copy, argv, (size_t)argc * sizeof(t_atom));
+
+    t_maxshim_entry* entry = maxshim_dictionary_find(d, key);
+    if (!entry) {
+        if (d->num_entries == d->capacity) {
+            long capacity = d->capacity ? d->capacity * 2 : 8;
+            t_maxshim_entry* entries = (t_maxshim_entry*)realloc(d->entries, (size_t)capacity * sizeof(t_maxshim_entry));
+            if (!entries) {
+                free(copy);
+                return MAX_ERR_GENERIC;
+            }
+            d->entries = entries;
+            d->capacity = capacity;
+        }
+        entry = &d->entries[d->num_entries++];
+        entry->key = key;
+        entry->argv = NULL;
+    }
+
+    free(entry->argv);
+    entry->argc = argc;
+    entry->argv = copy;
+    return MAX_ERR_NONE;
+}
@@ -0,0 +1,81 @@
+/**
+    @file
+    maxshim: host interface to the Max API stand-in
+
+    Lets a plain executable load an external built against the shim, create
+    instances, send them messages and run their perform routines, with the
+    scheduler clock under the host's control. Typical use:
+
+        ext_main(NULL);                                 // register the class
+        void* x = maxshim_new("tide~", 0, NULL);
+        short count[6] = { 0, 0, 0, 0, 0, 1 };          // inlets, then outlets
+        t_maxshim_dsp* dsp = maxshim_dsp_new(x, count, 48000.0, 64);
+        maxshim_float(x, 0, 2.0);                       // 2 Hz on inlet 0
+        maxshim_dsp_tick(dsp, ins, outs, 64);           // one vector
+        maxshim_settime(maxshim_gettime() + 64 / 48.0); // advance the scheduler
+        maxshim_dsp_free(dsp);
+        maxshim_free(x);
+
+    Messages and DSP compilation belong on one thread; perform may run on
+    another, as in Max. The scheduler time is shared by all instances.
+*/
+
+#ifndef MAXSHIM_H
+#define MAXSHIM_H
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "ext_dictobj.h"
+#include "ext_systhread.h"
+#include "z_dsp.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Instances of classes registered by an ext_main
+void* maxshim_new(const char* classname, long argc, t_atom* argv);
+void maxshim_free(void* x);
+long maxshim_numinlets(void* x);
+long maxshim_numoutlets(void* x);
+
+// Messages to a given inlet (what proxy_getinlet returns inside the handler)
+t_max_err maxshim_float(void* x, long inlet, double f);
+t_max_err maxshim_bang(void* x, long inlet);
+t_max_err maxshim_message(void* x, long inlet, const char* selector, long argc, t_atom* argv);   // A_GIMME methods
+
+// Double attributes, through the class's setter and filters
+t_max_err maxshim_attr_setfloat(void* x, const char* name, double value);
+t_max_err maxshim_attr_getfloat(void* x, const char* name, double* value);
+
+// DSP chain of one instance. count holds one flag per signal inlet followed by
+// one per signal outlet, nonzero when connected, as passed to the dsp64 method.
+typedef struct _maxshim_dsp t_maxshim_dsp;
+
+t_maxshim_dsp* maxshim_dsp_new(void* x, const short* count, double samplerate, long maxvectorsize);
+void maxshim_dsp_free(t_maxshim_dsp* dsp);
+long maxshim_dsp_routines(const t_maxshim_dsp* dsp);   // Perform routines added by dsp64
+void maxshim_dsp_tick(t_maxshim_dsp* dsp, double** ins, double** outs, long sampleframes);
+
+// Scheduler time returned by clock_getftime, in milliseconds
+void maxshim_settime(double ms);
+double maxshim_gettime(void);
+
+// Messages sent from outlets, numbered from 0 at the left. A "dictionary"
+// message can be read with dictobj_findregistered_retain during the hook.
+typedef void (*t_maxshim_outlet_hook)(void* x, long outlet, t_symbol* s, long argc, t_atom* argv, void* context);
+void maxshim_set_outlet_hook(t_maxshim_outlet_hook hook, void* context);
+
+// Runs the quit tasks installed by the externals, latest first, as Max does
+// on exit. Hosts call it before returning from main.
+void maxshim_quit(void);
+
+// Console output from post; NULL restores printing to stderr
+typedef void (*t_maxshim_post_hook)(const char* line, void* context);
+void maxshim_set_post_hook(t_maxshim_post_hook hook, void* context);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSHIM_H
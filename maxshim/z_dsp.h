@@ -0,0 +1,40 @@
+/**
+    @file
+    maxshim: stand-in for the Max SDK's z_dsp.h
+
+    MSP object header and signal setup. dsp_add64 is sent to the chain object
+    that maxshim_dsp_new passes to the dsp64 method.
+*/
+
+#ifndef MAXSHIM_Z_DSP_H
+#define MAXSHIM_Z_DSP_H
+
+#include "ext.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct t_pxobject
+{
+    t_object z_ob;
+    long z_in;
+    void* z_proxy;
+    long z_disabled;                // Set while the object is muted
+    short z_count;
+    short z_misc;
+} t_pxobject;
+
+typedef void (*t_perfroutine64)(t_object* x, t_object* dsp64, double** ins, long numins,
+                                double** outs, long numouts, long sampleframes, long flags,
+                                void* userparam);
+
+void class_dspinit(t_class* c);
+void dsp_setup(t_pxobject* x, long nsignals);
+void dsp_free(t_pxobject* x);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MAXSHIM_Z_DSP_H
@@ -1,18 +1,70 @@
 /**
  * C++ wrapper for Tides PolySlopeGenerator
  * Provides C interface for Max external
+ *
+ * The core has no Max dependency and keeps no shared mutable state on the
+ * render path, so separate generators can be rendered concurrently.
  */
 
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
+#include <new>
+#include <mutex>
+#include <vector>
 
-// Include Max headers for post() function
-extern "C" {
-#include "ext.h"
+#include "tides_wrapper.h"
+
+#if TIDES_STAGE_PROFILING
+#include <chrono>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace {
+
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || (!defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__)))
+const char kStageClockUnit[] = "cycles";
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+const char kStageClockUnit[] = "ticks";
+#else
+const char kStageClockUnit[] = "ns";
+#endif
+
+inline uint64_t StageClock() {
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || (!defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__)))
+    return __rdtsc();
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+    uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+// Smallest gap between two clock reads, measured once
+uint64_t StageClockOverhead() {
+    static const uint64_t overhead = [] {
+        uint64_t best = UINT64_MAX;
+        for (int i = 0; i < 1000; i++) {
+            uint64_t begin = StageClock();
+            uint64_t end = StageClock();
+            best = std::min(best, end - begin);
+        }
+        return best;
+    }();
+    return overhead;
 }
 
+} // namespace
+#endif
+
 // Create basic stmlib dependencies that Tides needs
 namespace stmlib {
     typedef unsigned char GateFlags;
@@ -70,6 +122,56 @@ enum Range {
     RANGE_LAST
 };
 
+// Compact looping generator of a tides_bank: the state and quantized
+// parameters a loop-mode sample needs, in 32 bytes instead of a 64-byte slot.
+// Phase and increment are 0.64 fixed-point fractions of a cycle; pw, shape,
+// smoothness and shift are unit values in Q15 (32768 = 1.0).
+struct BankGenerator {
+    uint64_t phase;
+    uint64_t increment;
+    float filter_lp_1;
+    float filter_lp_2;
+    uint16_t pw;
+    uint16_t shape;
+    uint16_t smoothness;
+    uint16_t shift;
+    
+    enum { kUnit = 32768 };
+    
+    void Init() {
+        phase = 0;
+        filter_lp_1 = 0.0f;
+        filter_lp_2 = 0.0f;
+        Set(0.01f, 0.5f, 0.0f, 0.0f, 0.0f);
+    }
+    
+    // Frequencies wrap modulo one cycle per sample, as the phase does. The
+    // increment resolves 2^-64 cycles, which holds every float frequency from
+    // 2^-41 cycles (2.2e-8 Hz at 48 kHz) up exactly; below that the error is
+    // at most 2^-65 cycles. The product stays below 2^64 as cycles < 1 - 2^-24.
+    void Set(float frequency, float pulse_width, float shape_value, float smoothness_value,
+             float shift_value) {
+        double cycles = frequency > 0.0f && std::isfinite(frequency)
+            ? (double)frequency - std::floor((double)frequency) : 0.0;
+        increment = (uint64_t)std::floor(cycles * 18446744073709551616.0 + 0.5);
+        pw = Quantize(pulse_width);
+        shape = Quantize(shape_value);
+        smoothness = Quantize(smoothness_value);
+        shift = Quantize(shift_value);
+    }
+    
+    static uint16_t Quantize(float value) {
+        value = value > 0.0f ? std::min(value, 1.0f) : 0.0f;  // NaN to 0
+        return (uint16_t)(value * (float)kUnit + 0.5f);
+    }
+    
+    static float Unit(uint16_t value) {
+        return (float)value * (1.0f / (float)kUnit);
+    }
+};
+
+static_assert(sizeof(BankGenerator) == 32, "BankGenerator layout changed");
+
 // Simplified PolySlopeGenerator implementation
 // This is a minimal version that captures the core Tides algorithm
 class PolySlopeGenerator {
@@ -101,6 +203,10 @@ public:
         // Initialize filter state
         filter_lp_1_ = 0.0f;
         filter_lp_2_ = 0.0f;
+        
+#if TIDES_STAGE_PROFILING
+        ClearStageProfile();
+#endif
     }
     
     void ResetPhase() {
@@ -114,6 +220,19 @@ public:
         filter_lp_2_ = 0.0f;
     }
     
+    // Moves the looping phase on by a number of cycles without rendering, so a
+    // generator that was not running stays in time. Filter state is kept.
+    void AdvancePhase(double cycles) {
+        if (!(cycles > 0.0)) return;
+        
+        phase_ += cycles;
+        phase_ -= std::floor(phase_);
+    }
+    
+    double Phase() const {
+        return phase_;
+    }
+    
     void Render(
         RampMode ramp_mode,
         OutputMode output_mode,
@@ -129,46 +248,12 @@ public:
         size_t size) {
         
         // Store parameters
-        frequency_ = std::max(frequency, 0.0f);  // Allow zero frequency
-        pw_ = std::max(0.001f, std::min(0.999f, pw));
-        shape_ = std::max(0.0f, std::min(1.0f, shape));
-        shift_ = std::max(0.0f, std::min(1.0f, shift));  // Phase offset parameter
-        
-        // Debug parameters once
-        static int debug_count = 0;
-        debug_count++;
-        if (debug_count == 100) {  // After 100 calls
-            post("Tides params: freq=%.9f, pw=%.3f, shape=%.3f", frequency_, pw_, shape_);
-        }
+        SetParameters(frequency, pw, shape, shift);
         
+        stmlib::GateFlags flags = gate_flags ? *gate_flags : 0;
         
         for (size_t i = 0; i < size; i++) {
-            // Handle gate logic for different modes
-            bool gate_high = gate_flags && (*gate_flags & 0x02);
-            bool gate_rising = gate_flags && (*gate_flags & 0x01);
-            
-            if (ramp_mode == RAMP_MODE_AD) {
-                if (gate_rising) {
-                    phase_ = 0.0f;
-                    rising_ = true;
-                }
-            } else if (ramp_mode == RAMP_MODE_AR) {
-                if (gate_rising) {
-                    phase_ = 0.0f;
-                    rising_ = true;
-                } else if (!gate_high && rising_) {
-                    rising_ = false;
-                }
-            }
-            
-            // Generate ramp
-            float ramp_output = GenerateRamp(ramp_mode, frequency_, shift_);
-            
-            // Apply shaping
-            float shaped = ApplyShaping(ramp_output, shape_, pw_);
-            
-            // Apply smoothing (filtering or folding)
-            float final_output = ApplySmoothing(shaped, smoothness);
+            float final_output = RenderSample(ramp_mode, flags, smoothness);
             
             // Fill output channels (all same for now)
             out[i].channel[0] = final_output;
@@ -177,6 +262,106 @@ public:
             out[i].channel[3] = final_output;
         }
     }
+    
+    // Constant-parameter kernel: parameters are clamped once for the whole
+    // block and the single used channel is written straight to the host buffer
+    void RenderBlock(
+        RampMode ramp_mode,
+        float frequency,
+        float pw,
+        float shape,
+        float smoothness,
+        float shift,
+        stmlib::GateFlags gate_flags,
+        double* out,
+        size_t size) {
+        
+        SetParameters(frequency, pw, shape, shift);
+        
+        if (!TIDES_STAGE_PROFILING && ramp_mode == RAMP_MODE_LOOPING && !gate_flags
+            && RenderFrozen(smoothness, out, size)) {
+            return;
+        }
+        
+        for (size_t i = 0; i < size; i++) {
+            out[i] = (double)RenderSample(ramp_mode, gate_flags, smoothness);
+        }
+    }
+    
+    enum { kBatchLanes = 8 };
+    
+    // Renders many generators with per-generator constant parameters. Parameter
+    // i is read from array[i * param_stride] and generator i writes size samples
+    // to out + i * out_stride. Groups of kBatchLanes looping generators run
+    // through a lane-parallel kernel; anything else falls back to RenderBlock.
+    static void RenderBatch(
+        PolySlopeGenerator* const* generators,
+        size_t count,
+        RampMode ramp_mode,
+        const float* frequency,
+        const float* pw,
+        const float* shape,
+        const float* smoothness,
+        const float* shift,
+        size_t param_stride,
+        double* out,
+        size_t out_stride,
+        size_t size) {
+        
+        for (size_t first = 0; first < count; first += kBatchLanes) {
+            size_t lanes = std::min((size_t)kBatchLanes, count - first);
+            
+            // The lane kernel unrolls the fold and phase wrap loops, which needs
+            // in-range phase, frequency and smoothness
+            bool lane_parallel = !TIDES_STAGE_PROFILING && ramp_mode == RAMP_MODE_LOOPING;
+            for (size_t l = 0; l < lanes && lane_parallel; l++) {
+                size_t p = (first + l) * param_stride;
+                PolySlopeGenerator* generator = generators[first + l];
+                lane_parallel = generator
+                    && generator->phase_ >= 0.0 && generator->phase_ < 1.0
+                    && frequency[p] < 1.0f
+                    && smoothness[p] >= 0.0f && smoothness[p] <= 1.0f;
+            }
+            
+            if (lane_parallel) {
+                RenderLanesLooping(
+                    generators + first, lanes,
+                    frequency + first * param_stride, pw + first * param_stride,
+                    shape + first * param_stride, smoothness + first * param_stride,
+                    shift + first * param_stride, param_stride,
+                    out + first * out_stride, out_stride, size);
+                continue;
+            }
+            
+            for (size_t l = 0; l < lanes; l++) {
+                size_t p = (first + l) * param_stride;
+                if (generators[first + l]) {
+                    generators[first + l]->RenderBlock(
+                        ramp_mode, frequency[p], pw[p], shape[p], smoothness[p], shift[p],
+                        0, out + (first + l) * out_stride, size);
+                }
+            }
+        }
+    }
+
+#if TIDES_STAGE_PROFILING
+    void GetStageProfile(tides_stage_profile* profile) const {
+        *profile = profile_;
+        profile->unit = kStageClockUnit;
+        profile->clock_overhead = StageClockOverhead();
+        
+        // Each stage of each sample spans one clock read; take those out
+        unsigned long long reads = profile->clock_overhead * profile->samples;
+        unsigned long long* stages[] = { &profile->ramp, &profile->shaping, &profile->smoothing };
+        for (unsigned long long* stage : stages) {
+            *stage = *stage > reads ? *stage - reads : 0;
+        }
+    }
+    
+    void ClearStageProfile() {
+        memset(&profile_, 0, sizeof(profile_));
+    }
+#endif
 
 private:
     float frequency_;
@@ -197,6 +382,340 @@ private:
     // Track rising/falling phase for shaping
     bool in_rising_phase_;
     
+#if TIDES_STAGE_PROFILING
+    tides_stage_profile profile_;
+#endif
+    
+    // Phase accumulators of the lane-parallel kernel, returning the float phase
+    // the ramp reads. Generators keep a double phase advanced by a float
+    // frequency and wrapped once; a tides_bank keeps a 0.64 fixed-point
+    // fraction of a cycle, which wraps by integer overflow and is rounded to
+    // float once. Where the double phase is a multiple of 2^-52, and so exact,
+    // both give the same float.
+    static inline float AdvanceLane(double& phase, float increment) {
+        double ph = phase + (double)increment;
+        ph = ph >= 1.0 ? ph - 1.0 : ph;
+        phase = ph;
+        return (float)ph;
+    }
+    
+    static inline float AdvanceLane(uint64_t& phase, uint64_t increment) {
+        phase += increment;
+        // Signed conversion of the top 63 bits; the dropped bit is 2^-64 cycles
+        return (float)(int64_t)(phase >> 1) * (1.0f / 9223372036854775808.0f);
+    }
+    
+    // Lane-parallel RAMP_MODE_LOOPING kernel: the state of up to kBatchLanes
+    // generators is held in local arrays and each stage of the per-sample chain
+    // runs across all lanes. The arithmetic mirrors GenerateRamp, ApplyShaping
+    // and ApplySmoothing operation for operation; data-dependent branches become
+    // selects, and the phase wrap and fold loops are unrolled to their bounds
+    // (one wrap for frequency < 1, four reflections for a fold gain up to 9).
+    template <typename Phase, typename Increment>
+    struct LoopingLanes {
+        enum { SHAPE_LINEAR, SHAPE_EXPONENTIAL, SHAPE_LOGARITHMIC };
+        enum { SMOOTH_NONE, SMOOTH_FILTER, SMOOTH_FOLD };
+        
+        Phase phase[kBatchLanes];
+        Increment increment[kBatchLanes];
+        float pw[kBatchLanes];
+        float shift[kBatchLanes];
+        int shape_mode[kBatchLanes];
+        float exponent[kBatchLanes];
+        int smooth_mode[kBatchLanes];
+        float cutoff[kBatchLanes];
+        float fold_gain[kBatchLanes];
+        float lp_1[kBatchLanes];
+        float lp_2[kBatchLanes];
+        float ramp[kBatchLanes];
+        bool rising[kBatchLanes];
+        
+        // Loads lane l with clamped parameters; shape and smoothness select the
+        // region ApplyShaping and ApplySmoothing would branch to
+        void Load(size_t l, Phase lane_phase, Increment lane_increment, float lane_pw,
+                  float sh, float s, float lane_shift, float lane_lp_1, float lane_lp_2) {
+            phase[l] = lane_phase;
+            increment[l] = lane_increment;
+            pw[l] = lane_pw;
+            shift[l] = lane_shift;
+            lp_1[l] = lane_lp_1;
+            lp_2[l] = lane_lp_2;
+            ramp[l] = 0.0f;
+            rising[l] = true;
+            
+            if (sh < 0.1f || sh == 0.5f) {
+                shape_mode[l] = SHAPE_LINEAR;
+                exponent[l] = 1.0f;
+            } else if (sh < 0.5f) {
+                shape_mode[l] = SHAPE_EXPONENTIAL;
+                exponent[l] = 1.0f + ((sh - 0.1f) / 0.4f) * 2.0f;
+            } else {
+                shape_mode[l] = SHAPE_LOGARITHMIC;
+                exponent[l] = 1.0f + ((sh - 0.5f) * 2.0f) * 2.0f;
+            }
+            
+            cutoff[l] = 0.0f;
+            fold_gain[l] = 1.0f;
+            if (s < 0.1f || s == 0.5f) {
+                smooth_mode[l] = SMOOTH_NONE;
+            } else if (s < 0.5f) {
+                smooth_mode[l] = SMOOTH_FILTER;
+                float c = (s - 0.1f) / 0.4f;
+                c = c * c;
+                cutoff[l] = std::max(c, 0.01f);
+            } else {
+                smooth_mode[l] = SMOOTH_FOLD;
+                fold_gain[l] = 1.0f + ((s - 0.5f) * 2.0f) * 8.0f;
+            }
+        }
+        
+        // Unused lanes run a silent linear generator so every loop has a fixed trip count
+        void LoadSilent(size_t l) {
+            Load(l, Phase(0), Increment(0), 0.5f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+        }
+        
+        void Render(size_t lanes, double* out, size_t out_stride, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                float unipolar[kBatchLanes];
+                float shaped[kBatchLanes];
+                
+                // GenerateRamp (looping)
+                for (size_t l = 0; l < kBatchLanes; l++) {
+                    float ph = AdvanceLane(phase[l], increment[l]);
+                    
+                    // fmodf(x, 1.0f) for x in [0, 2], exactly
+                    float effective = ph + shift[l];
+                    effective = effective >= 1.0f ? effective - 1.0f : effective;
+                    effective = effective >= 1.0f ? effective - 1.0f : effective;
+                    
+                    // Both slopes are computed so the choice is a select, not a branch
+                    bool up = effective < pw[l];
+                    float attack = effective / pw[l];
+                    float decay = 1.0f - (effective - pw[l]) / (1.0f - pw[l]);
+                    float r = (up ? attack : decay) * 2.0f - 1.0f;
+                    
+                    rising[l] = up;
+                    ramp[l] = r;
+                    unipolar[l] = (r + 1.0f) * 0.5f;
+                }
+                
+                // ApplyShaping: powf only for curved lanes
+                for (size_t l = 0; l < kBatchLanes; l++) {
+                    float u = unipolar[l];
+                    if (shape_mode[l] != SHAPE_LINEAR) {
+                        bool direct = (shape_mode[l] == SHAPE_EXPONENTIAL) == rising[l];
+                        u = direct ? powf(u, exponent[l]) : 1.0f - powf(1.0f - u, exponent[l]);
+                    }
+                    shaped[l] = u * 2.0f - 1.0f;
+                }
+                
+                // ApplySmoothing
+                for (size_t l = 0; l < kBatchLanes; l++) {
+                    float input = shaped[l];
+                    
+                    float next_1 = lp_1[l] + (input - lp_1[l]) * cutoff[l];
+                    float next_2 = lp_2[l] + (next_1 - lp_2[l]) * cutoff[l];
+                    bool filter = smooth_mode[l] == SMOOTH_FILTER;
+                    lp_1[l] = filter ? next_1 : lp_1[l];
+                    lp_2[l] = filter ? next_2 : lp_2[l];
+                    
+                    float folded = input * fold_gain[l];
+                    folded = folded > 1.0f ? 2.0f - folded : (folded < -1.0f ? -2.0f - folded : folded);
+                    folded = folded > 1.0f ? 2.0f - folded : (folded < -1.0f ? -2.0f - folded : folded);
+                    folded = folded > 1.0f ? 2.0f - folded : (folded < -1.0f ? -2.0f - folded : folded);
+                    folded = folded > 1.0f ? 2.0f - folded : (folded < -1.0f ? -2.0f - folded : folded);
+                    
+                    shaped[l] = filter ? next_2 : (smooth_mode[l] == SMOOTH_FOLD ? folded : input);
+                }
+                
+                for (size_t l = 0; l < lanes; l++) {
+                    out[l * out_stride + i] = (double)shaped[l];
+                }
+            }
+        }
+    };
+    
+    static void RenderLanesLooping(
+        PolySlopeGenerator* const* generators,
+        size_t lanes,
+        const float* frequency,
+        const float* pw,
+        const float* shape,
+        const float* smoothness,
+        const float* shift,
+        size_t param_stride,
+        double* out,
+        size_t out_stride,
+        size_t size) {
+        
+        LoopingLanes<double, float> state;
+        for (size_t l = 0; l < kBatchLanes; l++) {
+            PolySlopeGenerator* g = l < lanes ? generators[l] : nullptr;
+            if (!g) {
+                state.LoadSilent(l);
+                continue;
+            }
+            size_t p = l * param_stride;
+            g->SetParameters(frequency[p], pw[p], shape[p], shift[p]);
+            state.Load(l, g->phase_, g->frequency_, g->pw_, g->shape_, smoothness[p], g->shift_,
+                       g->filter_lp_1_, g->filter_lp_2_);
+            state.ramp[l] = g->ramp_value_;
+            state.rising[l] = g->in_rising_phase_;
+        }
+        
+        state.Render(lanes, out, out_stride, size);
+        
+        for (size_t l = 0; l < lanes; l++) {
+            PolySlopeGenerator* g = generators[l];
+            g->phase_ = state.phase[l];
+            g->ramp_value_ = state.ramp[l];
+            g->in_rising_phase_ = state.rising[l];
+            g->filter_lp_1_ = state.lp_1[l];
+            g->filter_lp_2_ = state.lp_2[l];
+        }
+    }
+    
+public:
+    // Renders consecutive bank generators through the lane kernel. Parameters
+    // are decoded and pw clamped as SetParameters does; ramp and rising state
+    // only feed the next sample in loop mode, so a bank does not keep them.
+    static void RenderBank(BankGenerator* generators, size_t count, double* out, size_t out_stride,
+                           size_t size) {
+        for (size_t first = 0; first < count; first += kBatchLanes) {
+            size_t lanes = std::min((size_t)kBatchLanes, count - first);
+            BankGenerator* g = generators + first;
+            
+            LoopingLanes<uint64_t, uint64_t> state;
+            for (size_t l = 0; l < kBatchLanes; l++) {
+                if (l >= lanes) {
+                    state.LoadSilent(l);
+                    continue;
+                }
+                float lane_pw = std::max(0.001f, std::min(0.999f, BankGenerator::Unit(g[l].pw)));
+                state.Load(l, g[l].phase, g[l].increment, lane_pw, BankGenerator::Unit(g[l].shape),
+                           BankGenerator::Unit(g[l].smoothness), BankGenerator::Unit(g[l].shift),
+                           g[l].filter_lp_1, g[l].filter_lp_2);
+            }
+            
+            state.Render(lanes, out + first * out_stride, out_stride, size);
+            
+            for (size_t l = 0; l < lanes; l++) {
+                g[l].phase = state.phase[l];
+                g[l].filter_lp_1 = state.lp_1[l];
+                g[l].filter_lp_2 = state.lp_2[l];
+            }
+        }
+    }
+    
+    // Hot bytes are the fields a loop-mode sample reads or writes; the rest of
+    // the object (AD/AR state, unused fold amount, padding) is cold
+    static void GetFootprint(tides_footprint* footprint) {
+        footprint->generator_size = sizeof(PolySlopeGenerator);
+        footprint->generator_slot = TIDES_GENERATOR_SIZE;
+        footprint->generator_hot = sizeof(frequency_) + sizeof(pw_) + sizeof(shift_) + sizeof(shape_)
+            + sizeof(phase_) + sizeof(ramp_value_) + sizeof(filter_lp_1_) + sizeof(filter_lp_2_)
+            + sizeof(in_rising_phase_);
+        footprint->bank_generator_size = sizeof(BankGenerator);
+    }
+    
+private:
+    void SetParameters(float frequency, float pw, float shape, float shift) {
+        frequency_ = std::max(frequency, 0.0f);  // Allow zero frequency
+        pw_ = std::max(0.001f, std::min(0.999f, pw));
+        shape_ = std::max(0.0f, std::min(1.0f, shape));
+        shift_ = std::max(0.0f, std::min(1.0f, shift));  // Phase offset parameter
+    }
+    
+    // Idle fast path for RenderBlock in loop mode. When the phase moves too
+    // little to change its float value over the block (frequency zero or far
+    // below one ulp per block), ramp and shaping give the same value for every
+    // sample. Only the low-pass state still moves; once an update leaves it
+    // unchanged the rest of the block is a plain fill. Output and state match
+    // the per-sample path exactly. Returns false when the block is not frozen.
+    bool RenderFrozen(float smoothness, double* out, size_t size) {
+        if (size < 2 || !(phase_ >= 0.0)) return false;
+        
+        double first_phase = phase_ + (double)frequency_;
+        
+        // Cheap estimate first, then the exact accumulation GenerateRamp would do
+        if ((float)(phase_ + (double)frequency_ * (double)size) != (float)first_phase) return false;
+        double end_phase = phase_;
+        for (size_t i = 0; i < size && frequency_ != 0.0f; i++) {
+            end_phase += (double)frequency_;
+        }
+        if (!(end_phase < 1.0) || (float)end_phase != (float)first_phase) return false;
+        
+        float shaped = ApplyShaping(GenerateRamp(RAMP_MODE_LOOPING, frequency_, shift_), shape_, pw_);
+        float value = ApplySmoothing(shaped, smoothness);
+        out[0] = (double)value;
+        
+        size_t i = 1;
+        while (i < size) {
+            float lp_1 = filter_lp_1_;
+            float lp_2 = filter_lp_2_;
+            value = ApplySmoothing(shaped, smoothness);
+            out[i++] = (double)value;
+            if (filter_lp_1_ == lp_1 && filter_lp_2_ == lp_2) {
+                break;  // Fixed point: every further sample repeats this one
+            }
+        }
+        std::fill(out + i, out + size, (double)value);
+        
+        phase_ = end_phase;
+        return true;
+    }
+    
+    inline float RenderSample(RampMode ramp_mode, stmlib::GateFlags gate_flags, float smoothness) {
+        // Handle gate logic for different modes
+        bool gate_high = gate_flags & 0x02;
+        bool gate_rising = gate_flags & 0x01;
+        
+        if (ramp_mode == RAMP_MODE_AD) {
+            if (gate_rising) {
+                phase_ = 0.0f;
+                rising_ = true;
+            }
+        } else if (ramp_mode == RAMP_MODE_AR) {
+            if (gate_rising) {
+                phase_ = 0.0f;
+                rising_ = true;
+            } else if (!gate_high && rising_) {
+                rising_ = false;
+            }
+        }
+        
+#if TIDES_STAGE_PROFILING
+        uint64_t ramp_start = StageClock();
+        float ramp_output = GenerateRamp(ramp_mode, frequency_, shift_);
+        uint64_t shaping_start = StageClock();
+        float shaped = ApplyShaping(ramp_output, shape_, pw_);
+        uint64_t smoothing_start = StageClock();
+        float smoothed = ApplySmoothing(shaped, smoothness);
+        uint64_t end = StageClock();
+        
+        profile_.samples++;
+        profile_.ramp += shaping_start - ramp_start;
+        profile_.shaping += smoothing_start - shaping_start;
+        profile_.smoothing += end - smoothing_start;
+        profile_.shape_samples[shape_ < 0.1f ? TIDES_SHAPE_LINEAR
+                               : shape_ < 0.5f ? TIDES_SHAPE_EXPONENTIAL
+                               : shape_ > 0.5f ? TIDES_SHAPE_LOGARITHMIC : TIDES_SHAPE_LINEAR]++;
+        profile_.smooth_samples[smoothness < 0.1f ? TIDES_SMOOTH_NONE
+                                : smoothness < 0.5f ? TIDES_SMOOTH_FILTER
+                                : smoothness > 0.5f ? TIDES_SMOOTH_FOLD : TIDES_SMOOTH_NONE]++;
+        return smoothed;
+#else
+        // Generate ramp
+        float ramp_output = GenerateRamp(ramp_mode, frequency_, shift_);
+        
+        // Apply shaping
+        float shaped = ApplyShaping(ramp_output, shape_, pw_);
+        
+        // Apply smoothing (filtering or folding)
+        return ApplySmoothing(shaped, smoothness);
+#endif
+    }
+    
     float GenerateRamp(RampMode mode, float frequency, float phase_shift = 0.0f) {
         phase_ += (double)frequency;  // Cast to double for accumulation
         
@@ -321,12 +840,116 @@ private:
 
 } // namespace tides
 
+// Hosts embed generators in opaque blocks sized from the C header
+static_assert(sizeof(tides::PolySlopeGenerator) <= TIDES_GENERATOR_SIZE,
+              "TIDES_GENERATOR_SIZE too small for PolySlopeGenerator");
+static_assert(alignof(tides::PolySlopeGenerator) <= TIDES_GENERATOR_ALIGN,
+              "TIDES_GENERATOR_ALIGN too small for PolySlopeGenerator");
+
+namespace {
+
+void* AlignedAlloc(size_t size, size_t alignment) {
+#ifdef _WIN32
+    return _aligned_malloc(size, alignment);
+#else
+    void* ptr = nullptr;
+    return posix_memalign(&ptr, alignment, size) == 0 ? ptr : nullptr;
+#endif
+}
+
+void AlignedFree(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
+// Process-wide slab allocator for heap generators
+// Slots are cache-line sized and aligned, carved out of contiguous slabs so
+// that a patch full of generators sits in a dense block instead of being
+// scattered between unrelated allocations. Freed slots are reused LIFO.
+class GeneratorPool {
+public:
+    enum {
+        kSlotSize = TIDES_GENERATOR_SIZE,
+        kSlotAlign = TIDES_GENERATOR_ALIGN,
+        kSlotsPerSlab = 256
+    };
+
+    GeneratorPool() : free_list_(nullptr) { }
+
+    void* Allocate() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!free_list_ && !Grow()) {
+            return nullptr;
+        }
+        FreeSlot* slot = free_list_;
+        free_list_ = slot->next;
+        return slot;
+    }
+
+    void Free(void* ptr) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FreeSlot* slot = static_cast<FreeSlot*>(ptr);
+        slot->next = free_list_;
+        free_list_ = slot;
+    }
+
+private:
+    struct FreeSlot {
+        FreeSlot* next;
+    };
+
+    bool Grow() {
+        void* slab = AlignedAlloc(kSlotSize * kSlotsPerSlab, kSlotAlign);
+        if (!slab) {
+            return false;
+        }
+        slabs_.push_back(slab);
+
+        // Thread the new slots so they are handed out in address order
+        unsigned char* base = static_cast<unsigned char*>(slab);
+        for (int i = kSlotsPerSlab - 1; i >= 0; i--) {
+            FreeSlot* slot = reinterpret_cast<FreeSlot*>(base + i * kSlotSize);
+            slot->next = free_list_;
+            free_list_ = slot;
+        }
+        return true;
+    }
+
+    std::mutex mutex_;
+    FreeSlot* free_list_;
+    std::vector<void*> slabs_;  // Kept for the lifetime of the process
+};
+
+static_assert(GeneratorPool::kSlotSize % GeneratorPool::kSlotAlign == 0,
+              "Pool slots must keep every generator cache-line aligned");
+
+// Never destroyed: generators may still be released during static teardown
+GeneratorPool& Pool() {
+    static GeneratorPool* pool = new GeneratorPool();
+    return *pool;
+}
+
+} // namespace
+
+// Generators of a bank are contiguous and cache-line aligned
+struct tides_bank {
+    size_t count;
+    tides::BankGenerator* generators;
+};
+
 // C interface functions
 extern "C" {
 
 void* tides_create(void) {
     try {
-        return new tides::PolySlopeGenerator();
+        void* slot = Pool().Allocate();
+        if (!slot) {
+            return nullptr;
+        }
+        return new (slot) tides::PolySlopeGenerator();
     } catch (...) {
         return nullptr;
     }
@@ -334,11 +957,30 @@ void* tides_create(void) {
 
 void tides_destroy(void* tides_obj) {
     if (tides_obj) {
-        delete static_cast<tides::PolySlopeGenerator*>(tides_obj);
+        static_cast<tides::PolySlopeGenerator*>(tides_obj)->~PolySlopeGenerator();
+        Pool().Free(tides_obj);
+    }
+}
+
+void* tides_create_in_place(void* storage) {
+    if (!storage) return nullptr;
+    return new (storage) tides::PolySlopeGenerator();
+}
+
+void tides_destroy_in_place(void* tides_obj) {
+    if (tides_obj) {
+        static_cast<tides::PolySlopeGenerator*>(tides_obj)->~PolySlopeGenerator();
     }
 }
 
+size_t tides_generator_size(void) {
+    return sizeof(tides::PolySlopeGenerator);
+}
+
 void tides_init(void* tides_obj) {
+#if TIDES_STAGE_PROFILING
+    StageClockOverhead();   // Measured here so the audio thread never pays for it
+#endif
     if (tides_obj) {
         static_cast<tides::PolySlopeGenerator*>(tides_obj)->Init();
     }
@@ -350,6 +992,17 @@ void tides_reset_phase(void* tides_obj) {
     }
 }
 
+void tides_advance_phase(void* tides_obj, double cycles) {
+    if (tides_obj) {
+        static_cast<tides::PolySlopeGenerator*>(tides_obj)->AdvancePhase(cycles);
+    }
+}
+
+double tides_get_phase(const void* tides_obj) {
+    if (!tides_obj) return 0.0;
+    return static_cast<const tides::PolySlopeGenerator*>(tides_obj)->Phase();
+}
+
 void tides_render(void* tides_obj, int ramp_mode, int output_mode, int range,
                   float frequency, float pw, float shape, float smoothness, float shift,
                   unsigned char gate_flags, float* output) {
@@ -376,4 +1029,130 @@ void tides_render(void* tides_obj, int ramp_mode, int output_mode, int range,
     output[0] = out_sample.channel[0];
 }
 
-} // extern "C"
\ No newline at end of file
+void tides_render_block(void* tides_obj, int ramp_mode, int output_mode, int range,
+                        float frequency, float pw, float shape, float smoothness, float shift,
+                        unsigned char gate_flags, double* output, size_t size) {
+    
+    if (!tides_obj || !output) return;
+    
+    static_cast<tides::PolySlopeGenerator*>(tides_obj)->RenderBlock(
+        static_cast<tides::RampMode>(ramp_mode),
+        frequency, pw, shape, smoothness, shift,
+        gate_flags,
+        output,
+        size
+    );
+}
+
+void tides_render_batch(void* const* tides_objs, size_t count, int ramp_mode, int output_mode, int range,
+                        const float* frequency, const float* pw, const float* shape,
+                        const float* smoothness, const float* shift, size_t param_stride,
+                        double* output, size_t output_stride, size_t size) {
+    
+    if (!tides_objs || !output || !frequency || !pw || !shape || !smoothness || !shift) return;
+    
+    tides::PolySlopeGenerator::RenderBatch(
+        reinterpret_cast<tides::PolySlopeGenerator* const*>(tides_objs),
+        count,
+        static_cast<tides::RampMode>(ramp_mode),
+        frequency, pw, shape, smoothness, shift, param_stride,
+        output, output_stride,
+        size
+    );
+}
+
+void tides_get_footprint(tides_footprint* footprint) {
+    if (footprint) {
+        tides::PolySlopeGenerator::GetFootprint(footprint);
+    }
+}
+
+tides_bank* tides_bank_create(size_t count) {
+    if (count > SIZE_MAX / sizeof(tides::BankGenerator)) return nullptr;
+    
+    tides_bank* bank = static_cast<tides_bank*>(malloc(sizeof(tides_bank)));
+    void* storage = AlignedAlloc(std::max(count, (size_t)1) * sizeof(tides::BankGenerator),
+                                 TIDES_GENERATOR_ALIGN);
+    if (!bank || !storage) {
+        free(bank);
+        AlignedFree(storage);
+        return nullptr;
+    }
+    bank->count = count;
+    bank->generators = static_cast<tides::BankGenerator*>(storage);
+    for (size_t i = 0; i < count; i++) {
+        bank->generators[i].Init();
+    }
+    return bank;
+}
+
+void tides_bank_destroy(tides_bank* bank) {
+    if (bank) {
+        AlignedFree(bank->generators);
+        free(bank);
+    }
+}
+
+size_t tides_bank_count(const tides_bank* bank) {
+    return bank ? bank->count : 0;
+}
+
+void tides_bank_set(tides_bank* bank, size_t index, float frequency, float pw, float shape,
+                    float smoothness, float shift) {
+    if (bank && index < bank->count) {
+        bank->generators[index].Set(frequency, pw, shape, smoothness, shift);
+    }
+}
+
+void tides_bank_reset_phase(tides_bank* bank, size_t index) {
+    if (bank && index < bank->count) {
+        tides::BankGenerator& g = bank->generators[index];
+        g.phase = 0;
+        g.filter_lp_1 = 0.0f;
+        g.filter_lp_2 = 0.0f;
+    }
+}
+
+double tides_bank_get_phase(const tides_bank* bank, size_t index) {
+    if (!bank || index >= bank->count) return 0.0;
+    return (double)bank->generators[index].phase * (1.0 / 18446744073709551616.0);
+}
+
+void tides_bank_render(tides_bank* bank, size_t first, size_t count,
+                       double* output, size_t output_stride, size_t size) {
+    if (!bank || !output || first >= bank->count) return;
+    
+    tides::PolySlopeGenerator::RenderBank(
+        bank->generators + first,
+        std::min(count, bank->count - first),
+        output, output_stride,
+        size
+    );
+}
+
+int tides_get_stage_profile(const void* tides_obj, tides_stage_profile* profile) {
+    if (!profile) return 0;
+    memset(profile, 0, sizeof(*profile));
+#if TIDES_STAGE_PROFILING
+    if (tides_obj) {
+        static_cast<const tides::PolySlopeGenerator*>(tides_obj)->GetStageProfile(profile);
+    } else {
+        profile->unit = kStageClockUnit;
+        profile->clock_overhead = StageClockOverhead();
+    }
+    return 1;
+#else
+    (void)tides_obj;
+    return 0;
+#endif
+}
+
+void tides_clear_stage_profile(void* tides_obj) {
+#if TIDES_STAGE_PROFILING
+    if (tides_obj) {
+        static_cast<tides::PolySlopeGenerator*>(tides_obj)->ClearStageProfile();
+    }
+#endif
+}
+
+} // extern "C"
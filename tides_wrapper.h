@@ -0,0 +1,164 @@
+/**
+ * C interface to the Tides PolySlopeGenerator core (tides_wrapper.cpp)
+ * Shared by the Max external and any other host of the core library
+ *
+ * Thread safety: all state lives in the generator, so the render and reset
+ * functions are reentrant. Different generators may be used from different
+ * threads at the same time; a single generator must not be used by two
+ * threads at once. Creation and destruction are safe from any thread.
+ */
+
+#ifndef TIDES_WRAPPER_H
+#define TIDES_WRAPPER_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Profiling build of the core: every sample is timed stage by stage (see
+// tides_get_stage_profile). Must be set alike for the core and its hosts,
+// since the generator then carries its counters and grows.
+#ifndef TIDES_STAGE_PROFILING
+#define TIDES_STAGE_PROFILING 0
+#endif
+
+// Storage needed to embed a generator inline in a host struct.
+// The core checks at compile time that the C++ object fits in this block.
+#if TIDES_STAGE_PROFILING
+#define TIDES_GENERATOR_SIZE 192
+#else
+#define TIDES_GENERATOR_SIZE 64
+#endif
+#define TIDES_GENERATOR_ALIGN 64
+
+// Heap generators, served from a process-wide pool of cache-line aligned slots
+void* tides_create(void);
+void tides_destroy(void* tides_obj);
+
+// Generators embedded in caller-owned storage of at least TIDES_GENERATOR_SIZE
+// bytes, aligned to TIDES_GENERATOR_ALIGN. Returns the generator handle.
+void* tides_create_in_place(void* storage);
+void tides_destroy_in_place(void* tides_obj);
+size_t tides_generator_size(void);
+
+void tides_init(void* tides_obj);
+void tides_reset_phase(void* tides_obj);
+
+// Advances a looping generator's phase by cycles without rendering
+// (e.g. frequency * samples while its host was bypassed)
+void tides_advance_phase(void* tides_obj, double cycles);
+
+// Current phase of the looping accumulator, in cycles from 0 up to 1
+double tides_get_phase(const void* tides_obj);
+
+void tides_render(void* tides_obj, int ramp_mode, int output_mode, int range,
+                  float frequency, float pw, float shape, float smoothness, float shift,
+                  unsigned char gate_flags, float* output);
+
+// Constant-parameter kernel: renders size samples with one parameter set,
+// writing the first output channel to output
+void tides_render_block(void* tides_obj, int ramp_mode, int output_mode, int range,
+                        float frequency, float pw, float shape, float smoothness, float shift,
+                        unsigned char gate_flags, double* output, size_t size);
+
+// Batch kernel: renders size samples for each of count generators in one call.
+// Generator i reads its constant parameters from frequency[i * param_stride]
+// (likewise pw, shape, smoothness, shift; pass one interleaved array with a
+// stride to use a struct-of-parameters layout) and writes its first output
+// channel to output + i * output_stride. Looping generators are processed
+// several at a time across SIMD lanes. NULL handles are skipped.
+void tides_render_batch(void* const* tides_objs, size_t count, int ramp_mode, int output_mode, int range,
+                        const float* frequency, const float* pw, const float* shape,
+                        const float* smoothness, const float* shift, size_t param_stride,
+                        double* output, size_t output_stride, size_t size);
+
+// Memory per generator, in bytes. A heap or embedded generator occupies a
+// whole slot; of its object, generator_hot bytes are touched by every
+// loop-mode sample and the rest (AD/AR state, padding) is cold. Bank
+// generators are hot throughout. Host state is not included: a tide~ object
+// also holds about 1.2 KB of its own (the event queue alone is 896 bytes),
+// which tide_load reports per instance.
+typedef struct tides_footprint
+{
+    size_t generator_size;          // sizeof the generator object
+    size_t generator_slot;          // TIDES_GENERATOR_SIZE
+    size_t generator_hot;
+    size_t bank_generator_size;     // One generator of a tides_bank
+} tides_footprint;
+
+void tides_get_footprint(tides_footprint* footprint);
+
+// Compact bank of looping generators for very large modulation fields. Each
+// generator is a 32-byte record in one contiguous array instead of a slot
+// plus caller-held parameters: the phase is a 64-bit fixed-point fraction of
+// a cycle and pw, shape, smoothness and shift are stored quantized to 2^-15.
+// Frequency wraps modulo one cycle per sample and is held to 2^-64 cycles per
+// sample: exactly from 2^-41 cycles (2.2e-8 Hz at 48 kHz) up, within 2^-65
+// cycles below, so no non-zero frequency above 1.3e-15 Hz at 48 kHz freezes.
+// Otherwise the output is that of tides_render_batch in loop mode with the
+// same, quantized, parameters. New generators have the defaults of
+// tides_init. Disjoint ranges of one bank may be rendered from different
+// threads at once.
+typedef struct tides_bank tides_bank;
+
+tides_bank* tides_bank_create(size_t count);    // NULL if out of memory
+void tides_bank_destroy(tides_bank* bank);
+size_t tides_bank_count(const tides_bank* bank);
+
+void tides_bank_set(tides_bank* bank, size_t index, float frequency, float pw, float shape,
+                    float smoothness, float shift);
+void tides_bank_reset_phase(tides_bank* bank, size_t index);
+double tides_bank_get_phase(const tides_bank* bank, size_t index);
+
+// Renders size samples for generators first to first + count - 1 (clipped to
+// the bank), generator first + i writing to output + i * output_stride
+void tides_bank_render(tides_bank* bank, size_t first, size_t count,
+                       double* output, size_t output_stride, size_t size);
+
+// Shape and smooth regions, as branched on by the shaping and smoothing stages
+enum {
+    TIDES_SHAPE_LINEAR,             // Below 0.1, or exactly 0.5
+    TIDES_SHAPE_EXPONENTIAL,        // 0.1 to 0.5
+    TIDES_SHAPE_LOGARITHMIC,        // Above 0.5
+    TIDES_SHAPE_REGIONS
+};
+enum {
+    TIDES_SMOOTH_NONE,              // Below 0.1, or exactly 0.5
+    TIDES_SMOOTH_FILTER,            // 0.1 to 0.5
+    TIDES_SMOOTH_FOLD,              // Above 0.5
+    TIDES_SMOOTH_REGIONS
+};
+
+// Time spent in each stage of the per-sample chain, in clock units (CPU cycles
+// on x86, generic timer ticks on ARM64, nanoseconds elsewhere). Each stage
+// of each sample spans one clock read; clock_overhead, the cheapest read, is
+// subtracted per sample from every stage figure, which stops at zero.
+// tides_init measures clock_overhead, so call it off the audio thread first.
+// Profiling builds render every sample through the timed chain, skipping the
+// frozen-block and lane-parallel fast paths.
+typedef struct tides_stage_profile
+{
+    const char* unit;
+    unsigned long long clock_overhead;
+    unsigned long long samples;
+    unsigned long long ramp;        // GenerateRamp
+    unsigned long long shaping;     // ApplyShaping
+    unsigned long long smoothing;   // ApplySmoothing
+    unsigned long long shape_samples[TIDES_SHAPE_REGIONS];
+    unsigned long long smooth_samples[TIDES_SMOOTH_REGIONS];
+} tides_stage_profile;
+
+// Copies a generator's counters since creation or the last clear. Returns 1 in
+// TIDES_STAGE_PROFILING builds, otherwise 0 with the profile zeroed. Call from
+// the thread that renders the generator; with a NULL generator only unit and
+// clock_overhead are filled, which is safe from any thread.
+int tides_get_stage_profile(const void* tides_obj, tides_stage_profile* profile);
+void tides_clear_stage_profile(void* tides_obj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // TIDES_WRAPPER_H
@@ -9,73 +9,475 @@
 #include "ext_obex.h"   // required for "new" style objects
 #include "z_dsp.h"      // required for MSP objects
 
-// Forward declaration for C++ Tides interface
-#ifdef __cplusplus
-extern "C" {
+#include "tides_wrapper.h"  // C interface to the Tides C++ core
+
+#include <math.h>
+#include <stdint.h>
+#include <stdatomic.h>      // C11 atomics; MSVC needs /experimental:c11atomics (see CMakeLists.txt)
+
+// Embed the generator in the object instead of allocating it separately
+#ifndef TIDE_INLINE_GENERATOR
+#define TIDE_INLINE_GENERATOR 1
 #endif
 
-// C wrapper functions for Tides C++ code
-void* tides_create(void);
-void tides_destroy(void* tides_obj);
-void tides_init(void* tides_obj);
-void tides_reset_phase(void* tides_obj);
-void tides_render(void* tides_obj, int ramp_mode, int output_mode, int range,
-                  float frequency, float pw, float shape, float smoothness, float shift,
-                  unsigned char gate_flags, float* output);
+// Per-instance profiling reported by the stats message; when 0 none of it is compiled
+#ifndef TIDE_ENABLE_STATS
+#define TIDE_ENABLE_STATS 0
+#endif
 
-#ifdef __cplusplus
-}
+// Timeline of perform calls recorded by "trace start" and written by "trace stop <file>";
+// when 0 none of it is compiled
+#ifndef TIDE_ENABLE_TRACE
+#define TIDE_ENABLE_TRACE 0
 #endif
 
-// struct to represent the object's state
-typedef struct _tide
+#if TIDE_ENABLE_STATS
+#include "ext_dictobj.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+#if TIDE_ENABLE_TRACE
+#include "ext_systhread.h"
+#include <stdio.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+#endif
+
+// Cache line size used to lay out the hot DSP state
+#define TIDE_CACHE_LINE 64
+
+// Bits of t_tide_hot.signal_mask, one per inlet with a signal connection
+enum {
+    TIDE_FREQ_SIGNAL    = 1 << 0,
+    TIDE_SHAPE_SIGNAL   = 1 << 1,
+    TIDE_SLOPE_SIGNAL   = 1 << 2,
+    TIDE_SMOOTH_SIGNAL  = 1 << 3,
+    TIDE_PHASE_SIGNAL   = 1 << 4
+};
+
+// Hot state: the audio thread's parameter snapshot and the state that feeds
+// the generator, packed into one cache line. Each vector also reads the
+// parameter buffer's counters and flags, the event queue's consumer line and
+// its next slot, and ob.z_disabled.
+typedef struct _tide_hot
 {
-    t_pxobject ob;                  // the object itself (t_pxobject for MSP)
-    
-    // Tides DSP object (opaque pointer to C++ object)
-    void* poly_slope_generator;
-    
-    
-    // Float parameters for control (set via messages)
+    // Audio thread's snapshot of the float parameters (see t_tide_params)
     double frequency_float;         // Frequency in Hz
     double shape_float;             // Shape parameter (0-1)
     double slope_float;             // Slope parameter (0-1, was called 'pw' in Tides)
     double smooth_float;            // Smoothness parameter (0-1)
     double phase_float;             // Phase offset (0-1)
-    double freq_scale;              // Frequency scaling factor
     
-    // Signal connection status (following lores~ pattern)
-    short freq_has_signal;          // 1 if frequency inlet has signal connection
-    short shape_has_signal;         // 1 if shape inlet has signal connection
-    short slope_has_signal;         // 1 if slope inlet has signal connection
-    short smooth_has_signal;        // 1 if smooth inlet has signal connection
-    short phase_has_signal;         // 1 if phase inlet has signal connection
+    // Hz to normalized phase increment: freq_scale / sample_rate
+    double freq_coeff;
+    
+    int signal_mask;                // TIDE_*_SIGNAL bits (following lores~ pattern)
+    unsigned int params_seen;       // t_tide_params.writes_done of the snapshot
+    
+#if TIDE_ENABLE_STATS
+    unsigned int stat_resets;       // Phase resets applied (published by tide_stats_record)
+    unsigned int stat_clamps;       // Signal frequency samples clamped to 0..Nyquist
+#endif
+} t_tide_hot;
+
+// Message-side parameter buffer, published to the audio thread
+// Handlers write a field between bumping writes_begun and writes_done; perform
+// copies the buffer into its hot snapshot once per vector, and only when no
+// write overlapped the copy. Neither side ever waits on the other: a copy that
+// raced a message is simply retried on the next vector.
+typedef struct _tide_params
+{
+    _Atomic double frequency_float;
+    _Atomic double shape_float;
+    _Atomic double slope_float;
+    _Atomic double smooth_float;
+    _Atomic double phase_float;
+    _Atomic double freq_coeff;
+    
+    atomic_uint writes_begun;
+    atomic_uint writes_done;
+    atomic_int reset_pending;       // 1 to reset phase on next vector (event queue full)
+    atomic_int resync_pending;      // 1 to take all float parameters on next vector (event queue full)
+} t_tide_params;
+
+// Timestamped parameter events, queued by message handlers for the audio thread
+#define TIDE_EVENT_QUEUE_SIZE 32    // Power of two
+#define TIDE_CLOCK_TOLERANCE_MS 10.0
+#define TIDE_CLOCK_CHECK_SAMPLES 64 // Samples between reads of the scheduler clock
+#define TIDE_CLOCK_BURST_LIMIT 16384 // Longest scheduler stall taken for an I/O buffer, samples
+
+// Largest vector size handled by tide_perform64_small
+#define TIDE_SMALL_VECTOR 16
+
+enum {
+    TIDE_EVENT_FREQUENCY = 0,       // Float events use their inlet number
+    TIDE_EVENT_SHAPE,
+    TIDE_EVENT_SLOPE,
+    TIDE_EVENT_SMOOTH,
+    TIDE_EVENT_PHASE,
+    TIDE_EVENT_RESET                // Phase reset from bang
+};
+
+typedef struct _tide_event
+{
+    atomic_uint sequence;           // Slot ownership (bounded multi-producer queue), less the slot index
+    int kind;                       // TIDE_EVENT_*
+    double time;                    // Scheduler time of the message in ms
+    double value;                   // Clamped parameter value
+} t_tide_event;
+
+// Producers only touch the head line, the audio thread only the consumer line.
+// Several threads may send messages (main and scheduler), so producers claim
+// slots with a compare-and-swap; a full queue falls back to t_tide_params.
+// Slot sequences are stored minus the slot's index, so the zeroed memory
+// object_alloc returns is already an empty queue and tide_new need not touch it.
+typedef struct _tide_events
+{
+    union {
+        atomic_uint head;
+        unsigned char line[TIDE_CACHE_LINE];
+    } producer;
+    union {
+        struct {
+            unsigned int tail;
+            int clock_anchored;     // 0 until vector_time has been read from the scheduler
+            int gap_pending;        // 1 after perform was left out (bypass, mute): the next clock read catches up
+            double vector_time;     // Scheduler time at the start of the next vector, ms
+            double samples_per_ms;
+            long clock_check;       // Samples left until the scheduler clock is read again
+            double clock_last;      // Scheduler time at the last read
+            long clock_stall;       // Samples rendered since the scheduler time last changed
+            long clock_burst;       // Most samples rendered under one scheduler time (an I/O buffer)
+        } state;
+        unsigned char line[TIDE_CACHE_LINE];
+    } consumer;
+    t_tide_event slots[TIDE_EVENT_QUEUE_SIZE];
+} t_tide_events;
+
+struct _tide;
+
+// Signature of the perform routines
+typedef void (*t_tide_perform)(struct _tide* x, t_object* dsp64, double** ins, long numins, double** outs,
+                               long numouts, long sampleframes, long flags, void* userparam);
+
+#if TIDE_ENABLE_STATS
+// Vector cost histogram: exact below 8, then 8 buckets per octave (within
+// 12.5%) up to 2^40; longer vectors land in the last bucket
+#define TIDE_STATS_SUB_BITS 3
+#define TIDE_STATS_OCTAVES 40
+#define TIDE_STATS_BUCKETS ((TIDE_STATS_OCTAVES - TIDE_STATS_SUB_BITS + 1) << TIDE_STATS_SUB_BITS)
+
+// Cost of each vector in the finest clock available
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || (!defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__)))
+#define TIDE_STATS_UNIT "cycles"
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+#define TIDE_STATS_UNIT "ticks"     // Generic timer (cntvct_el0)
+#else
+#define TIDE_STATS_UNIT "ns"
+#endif
+
+// Written by the audio thread only, read by the stats message. Fields are
+// individually atomic, so a report may mix two consecutive vectors.
+typedef struct _tide_stats
+{
+    t_tide_perform routine;         // Routine being measured, chosen by dsp64
+    _Atomic uint64_t vectors;
+    _Atomic uint64_t samples;
+    _Atomic uint64_t total;         // Sum of vector costs
+    _Atomic uint64_t min;
+    _Atomic uint64_t max;
+    _Atomic uint32_t resets;
+    _Atomic uint32_t clamps_signal;
+    atomic_uint clamps_message;     // Counted by message handlers
+    atomic_int clear_pending;       // Set by "stats clear", done by the audio thread
+    _Atomic uint32_t histogram[TIDE_STATS_BUCKETS];
+#if TIDES_STAGE_PROFILING
+    // Copy of the generator's stage profile (tides_get_stage_profile)
+    _Atomic uint64_t stage_samples;
+    _Atomic uint64_t stage_ramp;
+    _Atomic uint64_t stage_shaping;
+    _Atomic uint64_t stage_smoothing;
+    _Atomic uint64_t shape_regions[TIDES_SHAPE_REGIONS];
+    _Atomic uint64_t smooth_regions[TIDES_SMOOTH_REGIONS];
+#endif
+} t_tide_stats;
+#endif
+
+#if TIDE_ENABLE_TRACE
+// One ring per audio thread, shared by every instance on that thread. Threads
+// claim a ring on their first traced vector; the oldest events are overwritten,
+// so a trace holds the last TIDE_TRACE_EVENTS vectors of each thread.
+#define TIDE_TRACE_THREADS 8
+#define TIDE_TRACE_EVENTS 65536     // Power of two
+
+#if defined(_MSC_VER)
+#define TIDE_THREAD_LOCAL __declspec(thread)
+#else
+#define TIDE_THREAD_LOCAL _Thread_local
+#endif
+
+// Perform routines named in traces
+enum {
+    TIDE_TRACE_KERNEL_FULL = 0,     // tide_perform64
+    TIDE_TRACE_KERNEL_SMALL         // tide_perform64_small
+};
+
+// Written by one audio thread, read by the writer thread after recording stops.
+// An event is complete when its sequence matches its index in the ring.
+typedef struct _tide_trace_event
+{
+    _Atomic uint64_t sequence;      // Event index + 1, 0 while being written
+    _Atomic uint64_t begin;         // ns since trace start
+    _Atomic uint32_t duration;      // ns
+    _Atomic uint32_t instance;
+    _Atomic uint32_t vector_size;
+    _Atomic uint32_t kernel;        // TIDE_TRACE_KERNEL_*
+} t_tide_trace_event;
+
+typedef struct _tide_trace_ring
+{
+    _Atomic uint64_t head;          // Events appended this session
+    t_tide_trace_event events[TIDE_TRACE_EVENTS];
+} t_tide_trace_ring;
+
+// Process-wide recorder; "trace" messages change it from the main thread
+typedef struct _tide_trace
+{
+    atomic_int recording;
+    atomic_int writing;             // 1 while the writer thread owns the rings
+    atomic_uint session;            // Bumped by trace start so threads claim rings anew
+    atomic_uint rings_claimed;
+    atomic_uint dropped;            // Vectors from threads beyond TIDE_TRACE_THREADS
+    uint64_t origin;                // Clock at trace start
+    t_tide_trace_ring* rings;       // Allocated by the first trace start, freed at quit
+    t_systhread writer;
+    char path[MAX_PATH_CHARS];
+} t_tide_trace;
+#endif
+
+typedef char tide_hot_fits_cache_line[(sizeof(t_tide_hot) <= TIDE_CACHE_LINE) ? 1 : -1];
+typedef char tide_params_fit_cache_line[(sizeof(t_tide_params) <= TIDE_CACHE_LINE) ? 1 : -1];
+typedef char tide_events_fill_cache_lines[(sizeof(t_tide_events) % TIDE_CACHE_LINE == 0) ? 1 : -1];
+
+// Hot line, the generator when it is embedded, the message-side line, then the event queue
+#define TIDE_GENERATOR_LINES (TIDE_INLINE_GENERATOR ? TIDES_GENERATOR_SIZE / TIDE_CACHE_LINE : 0)
+#define TIDE_DSP_STORAGE_SIZE ((2 + TIDE_GENERATOR_LINES) * TIDE_CACHE_LINE + sizeof(t_tide_events))
+
+// struct to represent the object's state
+typedef struct _tide
+{
+    t_pxobject ob;                  // the object itself (t_pxobject for MSP)
+    
+    // Hot line, Tides DSP object, parameter buffer and event queue, placed on cache-line
+    // boundaries inside this block (object_alloc only guarantees malloc alignment, hence the padding)
+    unsigned char dsp_storage[TIDE_DSP_STORAGE_SIZE + TIDE_CACHE_LINE - 1];
     
+    // Cold state: only touched from messages, attributes and dsp64
     
-    // Gate flags (unused in loop mode but needed for Tides interface)
-    unsigned char gate_flags;       // Tides gate flags
+#if !TIDE_INLINE_GENERATOR
+    // Tides DSP object (opaque pointer to C++ object)
+    void* poly_slope_generator;
+#endif
     
-    // Phase reset flag
-    short reset_phase;              // 1 to reset phase on next sample
+    double freq_scale;              // Frequency scaling factor (attribute storage)
+    double sample_rate;             // Sample rate
+    int bypassed;                   // 1 when the last dsp64 left perform out (outlet unconnected)
     
-    // Sample rate
-    double sample_rate;
+#if TIDE_ENABLE_STATS
+    void* stats_outlet;             // Right outlet: stats dictionary
+    t_tide_stats stats;
+#endif
+    
+#if TIDE_ENABLE_TRACE
+    t_tide_perform trace_routine;   // Routine timed by tide_perform64_trace (the stats wrapper when both are on)
+    int trace_kernel;               // TIDE_TRACE_KERNEL_* chosen by dsp64
+    unsigned int trace_id;          // Instance number in trace files
+#endif
     
 } t_tide;
 
+// Address of the hot parameter line
+static inline t_tide_hot* tide_hot(t_tide* x)
+{
+    uintptr_t storage = (uintptr_t)x->dsp_storage;
+    return (t_tide_hot*)((storage + (TIDE_CACHE_LINE - 1)) & ~(uintptr_t)(TIDE_CACHE_LINE - 1));
+}
+
+// Address of the Tides DSP object
+static inline void* tide_generator(t_tide* x)
+{
+#if TIDE_INLINE_GENERATOR
+    return (unsigned char*)tide_hot(x) + TIDE_CACHE_LINE;
+#else
+    return x->poly_slope_generator;
+#endif
+}
+
+// Address of the message-side parameter buffer
+static inline t_tide_params* tide_params(t_tide* x)
+{
+    return (t_tide_params*)((unsigned char*)tide_hot(x) + (1 + TIDE_GENERATOR_LINES) * TIDE_CACHE_LINE);
+}
+
+// Address of the parameter event queue
+static inline t_tide_events* tide_events(t_tide* x)
+{
+    return (t_tide_events*)((unsigned char*)tide_hot(x) + (2 + TIDE_GENERATOR_LINES) * TIDE_CACHE_LINE);
+}
+
+// 1 when the parameter buffer holds something the audio snapshot has not taken yet
+static inline int tide_params_pending(t_tide_params* params, t_tide_hot* hot)
+{
+    return atomic_load_explicit(&params->writes_done, memory_order_relaxed) != hot->params_seen
+        || atomic_load_explicit(&params->resync_pending, memory_order_relaxed)
+        || atomic_load_explicit(&params->reset_pending, memory_order_relaxed);
+}
+
+// Phase reset on the audio thread
+static inline void tide_reset_phase(t_tide_hot* hot, void* generator)
+{
+    tides_reset_phase(generator);
+#if TIDE_ENABLE_STATS
+    hot->stat_resets++;
+#endif
+}
+
+#if TIDE_ENABLE_STATS
+static inline uint64_t tide_stats_clock(void)
+{
+#if (defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))) || (!defined(_MSC_VER) && (defined(__x86_64__) || defined(__i386__)))
+    return __rdtsc();
+#elif defined(__aarch64__) && !defined(_MSC_VER)
+    uint64_t ticks;
+    __asm__ volatile("mrs %0, cntvct_el0" : "=r"(ticks));
+    return ticks;
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+
+// Histogram bucket of a vector cost
+static inline int tide_stats_bucket(uint64_t cost)
+{
+    if (cost < (1u << TIDE_STATS_SUB_BITS)) {
+        return (int)cost;
+    }
+#if defined(_MSC_VER)
+    unsigned long octave;
+    _BitScanReverse64(&octave, cost);
+#else
+    int octave = 63 - __builtin_clzll(cost);
+#endif
+    if ((int)octave >= TIDE_STATS_OCTAVES) {
+        return TIDE_STATS_BUCKETS - 1;
+    }
+    return (((int)octave - TIDE_STATS_SUB_BITS + 1) << TIDE_STATS_SUB_BITS)
+         | (int)((cost >> ((int)octave - TIDE_STATS_SUB_BITS)) & ((1u << TIDE_STATS_SUB_BITS) - 1));
+}
+
+// Smallest cost that falls in a bucket
+static inline uint64_t tide_stats_bucket_floor(int bucket)
+{
+    if (bucket < (1 << TIDE_STATS_SUB_BITS)) {
+        return (uint64_t)bucket;
+    }
+    int octave = (bucket >> TIDE_STATS_SUB_BITS) + TIDE_STATS_SUB_BITS - 1;
+    uint64_t mantissa = (1u << TIDE_STATS_SUB_BITS) | (bucket & ((1u << TIDE_STATS_SUB_BITS) - 1));
+    return mantissa << (octave - TIDE_STATS_SUB_BITS);
+}
+
+// Counter update by its only writer: a plain load and store, no locked instruction
+static inline void tide_stats_store(_Atomic uint64_t* counter, uint64_t value)
+{
+    atomic_store_explicit(counter, value, memory_order_relaxed);
+}
+#endif
+
+#if TIDE_ENABLE_TRACE
+// Monotonic nanoseconds for trace timestamps
+static inline uint64_t tide_trace_clock(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (uint64_t)((double)count.QuadPart * 1e9 / (double)frequency.QuadPart);
+#else
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000u + (uint64_t)now.tv_nsec;
+#endif
+}
+#endif
+
 // Method prototypes
 void* tide_new(t_symbol* s, long argc, t_atom* argv);
 void tide_free(t_tide* x);
 void tide_assist(t_tide* x, void* b, long m, long a, char* s);
 void tide_float(t_tide* x, double f);
 void tide_bang(t_tide* x);
+t_max_err tide_freqscale_set(t_tide* x, void* attr, long argc, t_atom* argv);
 void tide_dsp64(t_tide* x, t_object* dsp64, short* count, double samplerate, long maxvectorsize, long flags);
 void tide_perform64(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam);
+void tide_perform64_small(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam);
+
+void tide_params_write(t_tide* x, _Atomic double* field, double value);
+void tide_params_acquire(t_tide* x, t_tide_hot* hot, void* generator);
+int tide_events_push(t_tide* x, int kind, double value);
+t_tide_event* tide_events_peek(t_tide_events* events);
+void tide_events_pop(t_tide_events* events);
+double tide_events_clock(t_tide_events* events, long sampleframes, double* resume_time);
+void tide_event_apply(t_tide_hot* hot, void* generator, const t_tide_event* event);
+void tide_skip(t_tide_hot* hot, void* generator, t_tide_events* events, double from, double to);
+void tide_render_span(t_tide_hot* hot, void* generator, double** ins, double* out, long start, long end);
+
+#if TIDE_ENABLE_STATS
+void tide_stats(t_tide* x, t_symbol* s, long argc, t_atom* argv);
+void tide_perform64_stats(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam);
+void tide_stats_record(t_tide* x, uint64_t cost, long sampleframes);
+void tide_stats_clear(t_tide* x);
+#endif
+
+#if TIDE_ENABLE_TRACE
+void tide_trace(t_tide* x, t_symbol* s, long argc, t_atom* argv);
+void tide_perform64_trace(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam);
+void tide_trace_record(t_tide* x, uint64_t begin, uint64_t end, long sampleframes);
+void* tide_trace_write(void* arg);
+void tide_trace_quit(void* arg);
+#endif
 
 
 // Global class pointer variable
 static t_class* tide_class = NULL;
 
+// Symbols looked up once in ext_main rather than per instance
+static t_symbol* tide_sym_dsp_add64 = NULL;
+
+// Scheduler time of the latest dsp64 call of any instance: once a chain is
+// compiled, about when it started. Objects that have not run since then catch up from it.
+static _Atomic double tide_chain_time;
+
+#if TIDE_ENABLE_TRACE
+// Trace recorder shared by all instances, and the source of their trace IDs
+static t_tide_trace tide_recorder;
+static atomic_uint tide_trace_instances;
+
+// Ring and session of the calling audio thread (see tide_trace_record)
+static TIDE_THREAD_LOCAL t_tide_trace_ring* tide_trace_ring_local = NULL;
+static TIDE_THREAD_LOCAL unsigned int tide_trace_session_local = 0;
+#endif
+
 //----------------------------------------------------------------------------------------------
 
 void ext_main(void* r)
@@ -87,9 +489,17 @@ void ext_main(void* r)
     class_addmethod(c, (method)tide_bang, "bang", 0);
     class_addmethod(c, (method)tide_dsp64, "dsp64", A_CANT, 0);
     class_addmethod(c, (method)tide_assist, "assist", A_CANT, 0);
+#if TIDE_ENABLE_STATS
+    class_addmethod(c, (method)tide_stats, "stats", A_GIMME, 0);
+#endif
+#if TIDE_ENABLE_TRACE
+    class_addmethod(c, (method)tide_trace, "trace", A_GIMME, 0);
+    quittask_install((method)tide_trace_quit, NULL);
+#endif
     
     // Add frequency scaling attribute
     CLASS_ATTR_DOUBLE(c, "freqscale", 0, t_tide, freq_scale);
+    CLASS_ATTR_ACCESSORS(c, "freqscale", NULL, tide_freqscale_set);
     CLASS_ATTR_FILTER_MIN(c, "freqscale", 0.0001);
     CLASS_ATTR_FILTER_MAX(c, "freqscale", 1.0);
     CLASS_ATTR_DEFAULT(c, "freqscale", 0, "1.0");
@@ -97,6 +507,8 @@ void ext_main(void* r)
     CLASS_ATTR_SAVE(c, "freqscale", 0);
     
     class_dspinit(c);
+    
+    tide_sym_dsp_add64 = gensym("dsp_add64");
 
 
     class_register(CLASS_BOX, c);
@@ -111,33 +523,75 @@ void* tide_new(t_symbol* s, long argc, t_atom* argv)
 
     if (x) {
         dsp_setup((t_pxobject*)x, 5);  // 5 inlets: freq, shape, slope, smooth, phase
+#if TIDE_ENABLE_STATS
+        x->stats_outlet = outlet_new(x, NULL);  // Created first so it sits on the right
+#endif
         outlet_new(x, "signal");        // 1 outlet: waveform
 
 
         // Create Tides C++ object
+#if TIDE_INLINE_GENERATOR
+        tides_create_in_place(tide_generator(x));
+#else
         x->poly_slope_generator = tides_create();
-        if (x->poly_slope_generator) {
-            tides_init(x->poly_slope_generator);
+#endif
+        if (tide_generator(x)) {
+            tides_init(tide_generator(x));
         }
 
         // Initialize parameters with defaults
-        x->frequency_float = 1.0;       // 1 Hz
-        x->shape_float = 0.0;           // Linear
-        x->slope_float = 0.5;           // Balanced attack/decay
-        x->smooth_float = 0.0;          // No smoothing
-        x->phase_float = 0.0;           // No phase offset
+        t_tide_hot* hot = tide_hot(x);
         x->freq_scale = 1.0;            // Default to 1.0 (no scaling)
+        x->sample_rate = 44100.0;
+        x->bypassed = 0;
+        hot->frequency_float = 1.0;     // 1 Hz
+        hot->shape_float = 0.0;         // Linear
+        hot->slope_float = 0.5;         // Balanced attack/decay
+        hot->smooth_float = 0.0;        // No smoothing
+        hot->phase_float = 0.0;         // No phase offset
+        hot->freq_coeff = x->freq_scale / x->sample_rate;
         
         // Initialize connection status (assume no signals connected initially)
-        x->freq_has_signal = 0;
-        x->shape_has_signal = 0;
-        x->slope_has_signal = 0;
-        x->smooth_has_signal = 0;
-        x->phase_has_signal = 0;
+        hot->signal_mask = 0;
         
-        x->gate_flags = 0;
-        x->reset_phase = 0;
-        x->sample_rate = 44100.0;
+        // Message-side buffer starts out equal to the audio snapshot
+        t_tide_params* params = tide_params(x);
+        atomic_init(&params->frequency_float, hot->frequency_float);
+        atomic_init(&params->shape_float, hot->shape_float);
+        atomic_init(&params->slope_float, hot->slope_float);
+        atomic_init(&params->smooth_float, hot->smooth_float);
+        atomic_init(&params->phase_float, hot->phase_float);
+        atomic_init(&params->freq_coeff, hot->freq_coeff);
+        atomic_init(&params->writes_begun, 0);
+        atomic_init(&params->writes_done, 0);
+        atomic_init(&params->reset_pending, 0);
+        atomic_init(&params->resync_pending, 0);
+        hot->params_seen = 0;
+        
+        // Empty event queue (slots stay zero); the audio clock is anchored on the first vector
+        t_tide_events* events = tide_events(x);
+        atomic_init(&events->producer.head, 0);
+        events->consumer.state.tail = 0;
+        events->consumer.state.clock_anchored = 0;
+        events->consumer.state.gap_pending = 0;
+        events->consumer.state.vector_time = 0.0;
+        events->consumer.state.clock_check = 0;
+        events->consumer.state.clock_last = 0.0;
+        events->consumer.state.clock_stall = 0;
+        events->consumer.state.clock_burst = 0;
+        events->consumer.state.samples_per_ms = x->sample_rate / 1000.0;
+        
+#if TIDE_ENABLE_STATS
+        x->stats.routine = NULL;
+        atomic_init(&x->stats.clamps_message, 0);
+        atomic_init(&x->stats.clear_pending, 0);
+        tide_stats_clear(x);
+#endif
+#if TIDE_ENABLE_TRACE
+        x->trace_routine = NULL;
+        x->trace_kernel = TIDE_TRACE_KERNEL_FULL;
+        x->trace_id = atomic_fetch_add_explicit(&tide_trace_instances, 1, memory_order_relaxed);
+#endif
 
         // Process attributes
         attr_args_process(x, argc, argv);
@@ -150,9 +604,13 @@ void* tide_new(t_symbol* s, long argc, t_atom* argv)
 
 void tide_free(t_tide* x)
 {
+#if TIDE_INLINE_GENERATOR
+    tides_destroy_in_place(tide_generator(x));
+#else
     if (x->poly_slope_generator) {
         tides_destroy(x->poly_slope_generator);
     }
+#endif
     
     
     dsp_free((t_pxobject*)x);
@@ -172,6 +630,12 @@ void tide_assist(t_tide* x, void* b, long m, long a, char* s)
         }
     }
     else {
+#if TIDE_ENABLE_STATS
+        if (a == 1) {
+            strcpy(s, "(dictionary) Stats");
+            return;
+        }
+#endif
         strcpy(s, "(signal) Waveform Output");
     }
 }
@@ -182,23 +646,49 @@ void tide_float(t_tide* x, double f)
 {
     // Route float messages to specific inlets
     long inlet = proxy_getinlet((t_object*)x);
+    t_tide_params* params = tide_params(x);
+    _Atomic double* field;
+#if TIDE_ENABLE_STATS
+    double requested = f;
+#endif
     
     switch (inlet) {
         case 0: 
-            x->frequency_float = CLAMP(f, 0.000001, 1000.0);  // Allow down to 0.000001 Hz
+            f = CLAMP(f, 0.000001, 1000.0);  // Allow down to 0.000001 Hz
+            field = &params->frequency_float;
             break;
         case 1: 
-            x->shape_float = CLAMP(f, 0.0, 1.0);
+            f = CLAMP(f, 0.0, 1.0);
+            field = &params->shape_float;
             break;
         case 2: 
-            x->slope_float = CLAMP(f, 0.0, 1.0);
+            f = CLAMP(f, 0.0, 1.0);
+            field = &params->slope_float;
             break;
         case 3: 
-            x->smooth_float = CLAMP(f, 0.0, 1.0);
+            f = CLAMP(f, 0.0, 1.0);
+            field = &params->smooth_float;
             break;
         case 4: 
-            x->phase_float = CLAMP(f, 0.0, 1.0);
+            f = CLAMP(f, 0.0, 1.0);
+            field = &params->phase_float;
             break;
+        default:
+            return;
+    }
+    
+#if TIDE_ENABLE_STATS
+    if (f != requested) {
+        atomic_fetch_add_explicit(&x->stats.clamps_message, 1, memory_order_relaxed);
+    }
+#endif
+    
+    // Keep the latest value in the parameter buffer, and let the audio thread apply
+    // it at the message's sample position; if the queue is full the value is taken
+    // at the next vector boundary instead
+    tide_params_write(x, field, f);
+    if (!tide_events_push(x, (int)inlet, f)) {
+        atomic_store_explicit(&params->resync_pending, 1, memory_order_release);
     }
 }
 
@@ -211,92 +701,912 @@ void tide_bang(t_tide* x)
     long inlet = proxy_getinlet((t_object*)x);
     
     if (inlet == 0) {  // Frequency inlet accepts bangs for phase reset
-        x->reset_phase = 1;  // Set flag to reset phase on next audio sample
+        // Reset phase at the bang's sample position (next vector if the queue is full)
+        if (!tide_events_push(x, TIDE_EVENT_RESET, 0.0)) {
+            atomic_store_explicit(&tide_params(x)->reset_pending, 1, memory_order_relaxed);
+        }
         post("tide~: phase reset");
     }
 }
 
 //----------------------------------------------------------------------------------------------
 
+t_max_err tide_freqscale_set(t_tide* x, void* attr, long argc, t_atom* argv)
+{
+    if (argc && argv) {
+        x->freq_scale = CLAMP(atom_getfloat(argv), 0.0001, 1.0);
+        tide_params_write(x, &tide_params(x)->freq_coeff, x->freq_scale / x->sample_rate);
+    }
+    return MAX_ERR_NONE;
+}
+
+//----------------------------------------------------------------------------------------------
+
 void tide_dsp64(t_tide* x, t_object* dsp64, short* count, double samplerate, long maxvectorsize, long flags)
 {
+    t_tide_hot* hot = tide_hot(x);
+    
     x->sample_rate = samplerate;
+    tide_params_write(x, &tide_params(x)->freq_coeff, x->freq_scale / x->sample_rate);
+    
+    t_tide_events* events = tide_events(x);
+    events->consumer.state.samples_per_ms = samplerate / 1000.0;
+    
+    double now;
+    clock_getftime(&now);
+    atomic_store_explicit(&tide_chain_time, now, memory_order_relaxed);
+    
+    // Nothing listens to an unconnected outlet: leave perform out of the chain.
+    // The event clock keeps the time of the last rendered vector (or starts at
+    // the chain's start) and the gap is recorded, so the first vector after
+    // reconnection advances the phase across it.
+    if (!count[5]) {
+        if (!events->consumer.state.clock_anchored) {
+            events->consumer.state.vector_time = now;
+            events->consumer.state.clock_anchored = 1;
+        }
+        x->bypassed = 1;
+        events->consumer.state.gap_pending = 1;
+        return;
+    }
+    
+    // Re-anchor the event clock when the chain restarts; the I/O buffer may have changed
+    if (!x->bypassed) {
+        events->consumer.state.clock_anchored = 0;
+        events->consumer.state.clock_burst = 0;
+    }
+    events->consumer.state.clock_check = 0;
+    x->bypassed = 0;
     
     // Store signal connection status (following lores~ pattern)
-    x->freq_has_signal = count[0];
-    x->shape_has_signal = count[1]; 
-    x->slope_has_signal = count[2];
-    x->smooth_has_signal = count[3];
-    x->phase_has_signal = count[4];
+    hot->signal_mask = (count[0] ? TIDE_FREQ_SIGNAL : 0)
+                     | (count[1] ? TIDE_SHAPE_SIGNAL : 0)
+                     | (count[2] ? TIDE_SLOPE_SIGNAL : 0)
+                     | (count[3] ? TIDE_SMOOTH_SIGNAL : 0)
+                     | (count[4] ? TIDE_PHASE_SIGNAL : 0);
     
-    object_method(dsp64, gensym("dsp_add64"), x, tide_perform64, 0, NULL);
+    // Feedback loops at tiny vector sizes get the routine with the least per-call work
+    t_tide_perform routine = (maxvectorsize <= TIDE_SMALL_VECTOR) ? tide_perform64_small : tide_perform64;
+    
+#if TIDE_ENABLE_TRACE
+    x->trace_kernel = (routine == tide_perform64_small) ? TIDE_TRACE_KERNEL_SMALL : TIDE_TRACE_KERNEL_FULL;
+#endif
+#if TIDE_ENABLE_STATS
+    // Time every vector through a wrapper around the chosen routine
+    x->stats.routine = routine;
+    routine = tide_perform64_stats;
+#endif
+#if TIDE_ENABLE_TRACE
+    // Outermost wrapper, so trace durations include the stats bookkeeping
+    x->trace_routine = routine;
+    routine = tide_perform64_trace;
+#endif
+    object_method(dsp64, tide_sym_dsp_add64, x, routine, 0, NULL);
 }
 
 //----------------------------------------------------------------------------------------------
 
-void tide_perform64(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam)
+void tide_params_write(t_tide* x, _Atomic double* field, double value)
 {
-    // Input buffers for all 5 inlets
-    double* freq_in = ins[0];
-    double* shape_in = ins[1];
-    double* slope_in = ins[2];
-    double* smooth_in = ins[3];
-    double* phase_in = ins[4];
+    // Called from the main or scheduler thread; never blocks
+    t_tide_params* params = tide_params(x);
+    
+    atomic_fetch_add_explicit(&params->writes_begun, 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(field, value, memory_order_relaxed);
+    atomic_fetch_add_explicit(&params->writes_done, 1, memory_order_release);
+}
 
-    // Output buffer
-    double* out = outs[0];
+//----------------------------------------------------------------------------------------------
 
-    // Check if Tides object exists
-    if (!x->poly_slope_generator) {
-        // Output silence if Tides object failed to create
-        for (long i = 0; i < sampleframes; i++) {
-            out[i] = 0.0;
+void tide_params_acquire(t_tide* x, t_tide_hot* hot, void* generator)
+{
+    // Called from the audio thread once per vector. Float parameters normally
+    // arrive through the event queue; the buffer supplies freq_coeff, and all
+    // values at once after the queue overflowed.
+    t_tide_params* params = tide_params(x);
+    
+    int resync = atomic_load_explicit(&params->resync_pending, memory_order_relaxed)
+        && atomic_exchange_explicit(&params->resync_pending, 0, memory_order_acquire);
+    
+    // Events claimed before this point were written to the buffer first, so the
+    // copy below holds their values (or newer ones); later events are kept
+    t_tide_events* events = tide_events(x);
+    unsigned int covered = resync ? atomic_load_explicit(&events->producer.head, memory_order_acquire) : 0;
+    
+    unsigned int done = atomic_load_explicit(&params->writes_done, memory_order_acquire);
+    if (done == hot->params_seen && !resync) {
+        return;  // Nothing new
+    }
+    
+    double frequency = 0.0, shape = 0.0, slope = 0.0, smooth = 0.0, phase = 0.0, freq_coeff = 0.0;
+    int consistent = 0;
+    
+    // Skip the copy while a message is mid-write
+    if (atomic_load_explicit(&params->writes_begun, memory_order_relaxed) == done) {
+        frequency = atomic_load_explicit(&params->frequency_float, memory_order_relaxed);
+        shape = atomic_load_explicit(&params->shape_float, memory_order_relaxed);
+        slope = atomic_load_explicit(&params->slope_float, memory_order_relaxed);
+        smooth = atomic_load_explicit(&params->smooth_float, memory_order_relaxed);
+        phase = atomic_load_explicit(&params->phase_float, memory_order_relaxed);
+        freq_coeff = atomic_load_explicit(&params->freq_coeff, memory_order_relaxed);
+        
+        // A message that started meanwhile may have left a mix of old and new values
+        atomic_thread_fence(memory_order_acquire);
+        consistent = (atomic_load_explicit(&params->writes_begun, memory_order_relaxed) == done);
+    }
+    
+    if (!consistent) {
+        // Keep the current snapshot for this vector and retry on the next one
+        if (resync) {
+            atomic_store_explicit(&params->resync_pending, 1, memory_order_relaxed);
         }
         return;
     }
+    
+    hot->freq_coeff = freq_coeff;
+    hot->params_seen = done;
+    
+    if (resync) {
+        // Events up to the head read above are older than the copy: keep their
+        // resets, drop their values
+        t_tide_event* event;
+        while ((int)(covered - events->consumer.state.tail) > 0 && (event = tide_events_peek(events))) {
+            if (event->kind == TIDE_EVENT_RESET) {
+                tide_reset_phase(hot, generator);
+            }
+            tide_events_pop(events);
+        }
+        
+        hot->frequency_float = frequency;
+        hot->shape_float = shape;
+        hot->slope_float = slope;
+        hot->smooth_float = smooth;
+        hot->phase_float = phase;
+    }
+}
 
-    // Process each sample
-    for (long i = 0; i < sampleframes; i++) {
-        // Choose signal vs float for each inlet (following lores~ pattern)
-        double current_freq = x->freq_has_signal ? freq_in[i] : x->frequency_float;
-        current_freq *= x->freq_scale;  // Apply frequency scaling
-        double current_shape = x->shape_has_signal ? shape_in[i] : x->shape_float;
-        double current_slope = x->slope_has_signal ? slope_in[i] : x->slope_float;
-        double current_smooth = x->smooth_has_signal ? smooth_in[i] : x->smooth_float;
-        double current_phase = x->phase_has_signal ? phase_in[i] : x->phase_float;
+//----------------------------------------------------------------------------------------------
 
-        // Convert frequency from Hz to normalized phase increment per sample
-        float norm_frequency = (float)(current_freq / x->sample_rate);
-        norm_frequency = CLAMP(norm_frequency, 0.0f, 0.5f);  // Remove lower limit
+int tide_events_push(t_tide* x, int kind, double value)
+{
+    // Called from the main or scheduler thread; returns 0 instead of waiting when full
+    t_tide_events* events = tide_events(x);
+    double time;
+    
+    clock_getftime(&time);
+    
+    unsigned int pos = atomic_load_explicit(&events->producer.head, memory_order_relaxed);
+    for (;;) {
+        unsigned int index = pos & (TIDE_EVENT_QUEUE_SIZE - 1);
+        t_tide_event* slot = &events->slots[index];
+        unsigned int sequence = atomic_load_explicit(&slot->sequence, memory_order_acquire) + index;
+        int diff = (int)(sequence - pos);
+        
+        if (diff == 0) {
+            // Slot is free: claim it, fill it, then hand it to the audio thread.
+            // The claim publishes the parameter buffer write made before it
+            // (see tide_params_acquire).
+            if (atomic_compare_exchange_weak_explicit(&events->producer.head, &pos, pos + 1,
+                                                      memory_order_release, memory_order_relaxed)) {
+                slot->kind = kind;
+                slot->time = time;
+                slot->value = value;
+                atomic_store_explicit(&slot->sequence, pos + 1 - index, memory_order_release);
+                return 1;
+            }
+        }
+        else if (diff < 0) {
+            return 0;  // Full: the audio thread has not consumed this slot yet
+        }
+        else {
+            pos = atomic_load_explicit(&events->producer.head, memory_order_relaxed);
+        }
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+t_tide_event* tide_events_peek(t_tide_events* events)
+{
+    unsigned int tail = events->consumer.state.tail;
+    unsigned int index = tail & (TIDE_EVENT_QUEUE_SIZE - 1);
+    t_tide_event* slot = &events->slots[index];
+    
+    if (atomic_load_explicit(&slot->sequence, memory_order_acquire) + index != tail + 1) {
+        return NULL;
+    }
+    return slot;
+}
 
-        // Handle phase reset from bang message
-        if (x->reset_phase) {
-            tides_reset_phase(x->poly_slope_generator);
-            x->reset_phase = 0;  // Clear the flag
+//----------------------------------------------------------------------------------------------
+
+void tide_events_pop(t_tide_events* events)
+{
+    unsigned int tail = events->consumer.state.tail;
+    unsigned int index = tail & (TIDE_EVENT_QUEUE_SIZE - 1);
+    t_tide_event* slot = &events->slots[index];
+    
+    atomic_store_explicit(&slot->sequence, tail + TIDE_EVENT_QUEUE_SIZE - index, memory_order_release);
+    events->consumer.state.tail = tail + 1;
+}
+
+//----------------------------------------------------------------------------------------------
+
+double tide_events_clock(t_tide_events* events, long sampleframes, double* resume_time)
+{
+    // Scheduler time at the start of this vector. The clock advances by the
+    // vector duration and is re-read from the scheduler only when the two drift
+    // apart, so events keep their relative sample positions. The scheduler is
+    // checked at most once per TIDE_CLOCK_CHECK_SAMPLES, i.e. every vector at
+    // the usual sizes and every few vectors at tiny ones.
+    // Max advances the scheduler once per I/O buffer, so drift up to one buffer
+    // (clock_burst, learned from the vectors rendered under one scheduler time)
+    // is expected and leaves the clock alone: vector_time stays the end of
+    // the audio rendered. The scheduler running further ahead means perform
+    // was not called (poly~ mute, bypass), whether or not anything said so; a
+    // recorded bypass or mute (gap_pending) counts beyond the tolerance alone.
+    // resume_time is then where the previous vector ended, or the chain's
+    // start if this object has not run since; otherwise it equals the start
+    // of this vector. The catch-up is exact when the scheduler is read on an
+    // update, and within one I/O buffer otherwise.
+    double vector_ms = (double)sampleframes / events->consumer.state.samples_per_ms;
+    double expected = events->consumer.state.vector_time;
+    
+    *resume_time = expected;
+    
+    if (!events->consumer.state.clock_anchored || events->consumer.state.clock_check <= 0) {
+        double now;
+        double tolerance = TIDE_CLOCK_TOLERANCE_MS + vector_ms;
+        
+        clock_getftime(&now);
+        events->consumer.state.clock_check = TIDE_CLOCK_CHECK_SAMPLES;
+        if (now != events->consumer.state.clock_last) {
+            events->consumer.state.clock_last = now;
+            events->consumer.state.clock_stall = 0;
         }
         
-        // No gate detection needed for loop mode - just clear flags
-        x->gate_flags = 0;
+        if (!events->consumer.state.clock_anchored) {
+            double chain_time = atomic_load_explicit(&tide_chain_time, memory_order_relaxed);
+            *resume_time = (now - chain_time > tolerance) ? chain_time : now;
+            events->consumer.state.vector_time = now;
+            events->consumer.state.clock_anchored = 1;
+        }
+        else {
+            double burst_ms = (double)events->consumer.state.clock_burst / events->consumer.state.samples_per_ms;
+            double drift = now - expected;
+            if (drift > (events->consumer.state.gap_pending ? tolerance : burst_ms + tolerance)) {
+                events->consumer.state.vector_time = now;   // Catch up from expected
+            }
+            else if (drift < -(burst_ms + tolerance)) {
+                *resume_time = now;
+                events->consumer.state.vector_time = now;
+            }
+        }
+        events->consumer.state.gap_pending = 0;
+    }
+    events->consumer.state.clock_check -= sampleframes;
+    if (events->consumer.state.clock_stall < TIDE_CLOCK_BURST_LIMIT) {
+        events->consumer.state.clock_stall += sampleframes;
+    }
+    if (events->consumer.state.clock_stall > events->consumer.state.clock_burst) {
+        events->consumer.state.clock_burst = events->consumer.state.clock_stall;
+    }
+    
+    double start = events->consumer.state.vector_time;
+    events->consumer.state.vector_time = start + vector_ms;
+    return start;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_event_apply(t_tide_hot* hot, void* generator, const t_tide_event* event)
+{
+    switch (event->kind) {
+        case TIDE_EVENT_FREQUENCY: hot->frequency_float = event->value; break;
+        case TIDE_EVENT_SHAPE: hot->shape_float = event->value; break;
+        case TIDE_EVENT_SLOPE: hot->slope_float = event->value; break;
+        case TIDE_EVENT_SMOOTH: hot->smooth_float = event->value; break;
+        case TIDE_EVENT_PHASE: hot->phase_float = event->value; break;
+        case TIDE_EVENT_RESET: tide_reset_phase(hot, generator); break;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_skip(t_tide_hot* hot, void* generator, t_tide_events* events, double from, double to)
+{
+    // Advance the phase from one scheduler time to another without rendering,
+    // applying the events that fell in between at their own times. Signal inlets
+    // are not read (their sources are usually muted too), so the float
+    // frequency sets the rate.
+    double samples_per_ms = events->consumer.state.samples_per_ms;
+    double cursor = from;
+    t_tide_event* event;
+    
+    while ((event = tide_events_peek(events)) && event->time < to) {
+        if (event->time > cursor) {
+            float norm_frequency = (float)(hot->frequency_float * hot->freq_coeff);
+            norm_frequency = CLAMP(norm_frequency, 0.0f, 0.5f);
+            tides_advance_phase(generator, (double)norm_frequency * (event->time - cursor) * samples_per_ms);
+            cursor = event->time;
+        }
+        tide_event_apply(hot, generator, event);
+        tide_events_pop(events);
+    }
+    
+    if (to > cursor) {
+        float norm_frequency = (float)(hot->frequency_float * hot->freq_coeff);
+        norm_frequency = CLAMP(norm_frequency, 0.0f, 0.5f);
+        tides_advance_phase(generator, (double)norm_frequency * (to - cursor) * samples_per_ms);
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_render_span(t_tide_hot* hot, void* generator, double** ins, double* out, long start, long end)
+{
+    int mask = hot->signal_mask;
+    double freq_coeff = hot->freq_coeff;
+    
+    if (!mask) {
+        // No signal inlets: constant parameters across the span
+        float norm_frequency = (float)(hot->frequency_float * freq_coeff);
+        norm_frequency = CLAMP(norm_frequency, 0.0f, 0.5f);
+        
+        tides_render_block(
+            generator,
+            1,                          // ramp_mode (1=Loop only)
+            1,                          // output_mode (1=AMPLITUDE for standard waveform)
+            1,                          // range (1=AUDIO)
+            norm_frequency,
+            (float)hot->slope_float,
+            (float)hot->shape_float,
+            (float)hot->smooth_float,
+            (float)hot->phase_float,
+            0,                          // gate flags
+            out + start,
+            (size_t)(end - start)
+        );
+        return;
+    }
+
+    // Choose signal vs float for each inlet once per span: unconnected inlets
+    // read their float parameter through a zero stride
+    const double* freq_in = (mask & TIDE_FREQ_SIGNAL) ? ins[0] : &hot->frequency_float;
+    const double* shape_in = (mask & TIDE_SHAPE_SIGNAL) ? ins[1] : &hot->shape_float;
+    const double* slope_in = (mask & TIDE_SLOPE_SIGNAL) ? ins[2] : &hot->slope_float;
+    const double* smooth_in = (mask & TIDE_SMOOTH_SIGNAL) ? ins[3] : &hot->smooth_float;
+    const double* phase_in = (mask & TIDE_PHASE_SIGNAL) ? ins[4] : &hot->phase_float;
+    long freq_step = (mask & TIDE_FREQ_SIGNAL) ? 1 : 0;
+    long shape_step = (mask & TIDE_SHAPE_SIGNAL) ? 1 : 0;
+    long slope_step = (mask & TIDE_SLOPE_SIGNAL) ? 1 : 0;
+    long smooth_step = (mask & TIDE_SMOOTH_SIGNAL) ? 1 : 0;
+    long phase_step = (mask & TIDE_PHASE_SIGNAL) ? 1 : 0;
+
+    // Process each sample
+    for (long i = start; i < end; i++) {
+        // Convert frequency from Hz to normalized phase increment per sample
+        // (freq_coeff folds in the frequency scaling)
+        float norm_frequency = (float)(freq_in[i * freq_step] * freq_coeff);
+#if TIDE_ENABLE_STATS
+        hot->stat_clamps += (norm_frequency < 0.0f || norm_frequency > 0.5f);
+#endif
+        norm_frequency = CLAMP(norm_frequency, 0.0f, 0.5f);  // Remove lower limit
 
         // Prepare output buffer for Tides (4 channels, we use first)
         float tides_output[4] = {0.0f, 0.0f, 0.0f, 0.0f};
 
-        // Call Tides render function (Loop mode only)
+        // Call Tides render function (Loop mode only, so no gates)
         tides_render(
-            x->poly_slope_generator,
+            generator,
             1,                          // ramp_mode (1=Loop only) 
             1,                          // output_mode (1=AMPLITUDE for standard waveform)
             1,                          // range (1=AUDIO)
             norm_frequency,             // frequency (normalized)
-            (float)current_slope,       // pw (pulse width/slope parameter)
-            (float)current_shape,       // shape
-            (float)current_smooth,      // smoothness
-            (float)current_phase,       // shift (phase offset)
-            x->gate_flags,              // gate flags
+            (float)slope_in[i * slope_step],    // pw (pulse width/slope parameter)
+            (float)shape_in[i * shape_step],    // shape
+            (float)smooth_in[i * smooth_step],  // smoothness
+            (float)phase_in[i * phase_step],    // shift (phase offset)
+            0,                          // gate flags
             tides_output                // output buffer
         );
 
         // Output the first channel
         out[i] = (double)tides_output[0];
     }
-}
\ No newline at end of file
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_perform64(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam)
+{
+    t_tide_hot* hot = tide_hot(x);
+    t_tide_params* params = tide_params(x);
+    t_tide_events* events = tide_events(x);
+
+    // Output buffer
+    double* out = outs[0];
+
+    void* generator = tide_generator(x);
+
+    // Check if Tides object exists
+    if (!generator) {
+        // Output silence if Tides object failed to create
+        for (long i = 0; i < sampleframes; i++) {
+            out[i] = 0.0;
+        }
+        return;
+    }
+    
+    // Pick up parameter changes made outside the event queue since the last vector
+    tide_params_acquire(x, hot, generator);
+
+    // Handle phase reset from a bang that did not fit in the event queue
+    if (atomic_load_explicit(&params->reset_pending, memory_order_relaxed)
+        && atomic_exchange_explicit(&params->reset_pending, 0, memory_order_relaxed)) {
+        tide_reset_phase(hot, generator);
+    }
+    
+    // Muted (mute~, pcontrol): nothing is rendered and the event clock stands
+    // still; the first vector after unmuting catches up with the scheduler, as
+    // after a bypass. When Max skips perform instead (poly~ mute), the
+    // scheduler running ahead of the event clock shows the gap
+    if (x->ob.z_disabled) {
+        events->consumer.state.gap_pending = 1;
+        events->consumer.state.clock_check = 0;
+        return;
+    }
+    
+    double resume_time;
+    double vector_time = tide_events_clock(events, sampleframes, &resume_time);
+    double samples_per_ms = events->consumer.state.samples_per_ms;
+    
+    // Catch up on the time perform was not called, so the LFO stays in time
+    if (resume_time < vector_time) {
+        tide_skip(hot, generator, events, resume_time, vector_time);
+    }
+    
+    // Render the vector in spans split at the sample position of each due event
+    long start = 0;
+    
+    while (start < sampleframes) {
+        long end = sampleframes;
+        t_tide_event* event = tide_events_peek(events);
+        
+        if (event) {
+            double offset = floor((event->time - vector_time) * samples_per_ms + 0.5);
+            if (offset < (double)sampleframes) {
+                end = (offset > (double)start) ? (long)offset : start;  // Late events apply right away
+            }
+            else {
+                event = NULL;  // Due in a later vector
+            }
+        }
+        
+        if (end > start) {
+            tide_render_span(hot, generator, ins, out, start, end);
+        }
+        if (event) {
+            tide_event_apply(hot, generator, event);
+            tide_events_pop(events);
+        }
+        start = end;
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_perform64_small(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam)
+{
+    t_tide_hot* hot = tide_hot(x);
+    t_tide_events* events = tide_events(x);
+    void* generator = tide_generator(x);
+    
+    // Anything but plain rendering goes through the full routine: a missing
+    // generator, parameter buffer updates and resets, queued events, mute and
+    // the periodic scheduler clock check
+    if (!generator
+        || events->consumer.state.clock_check <= 0
+        || x->ob.z_disabled
+        || tide_params_pending(tide_params(x), hot)
+        || tide_events_peek(events)) {
+        tide_perform64(x, dsp64, ins, numins, outs, numouts, sampleframes, flags, userparam);
+        return;
+    }
+    
+    events->consumer.state.clock_check -= sampleframes;
+    events->consumer.state.vector_time += (double)sampleframes / events->consumer.state.samples_per_ms;
+    
+    tide_render_span(hot, generator, ins, outs[0], 0, sampleframes);
+}
+
+#if TIDE_ENABLE_STATS
+
+//----------------------------------------------------------------------------------------------
+
+void tide_perform64_stats(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam)
+{
+    t_tide_stats* stats = &x->stats;
+    
+    if (atomic_load_explicit(&stats->clear_pending, memory_order_relaxed)
+        && atomic_exchange_explicit(&stats->clear_pending, 0, memory_order_acquire)) {
+        tide_stats_clear(x);
+    }
+    
+    uint64_t begin = tide_stats_clock();
+    stats->routine(x, dsp64, ins, numins, outs, numouts, sampleframes, flags, userparam);
+    tide_stats_record(x, tide_stats_clock() - begin, sampleframes);
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_stats_record(t_tide* x, uint64_t cost, long sampleframes)
+{
+    // Audio thread, after each vector
+    t_tide_stats* stats = &x->stats;
+    t_tide_hot* hot = tide_hot(x);
+    
+    tide_stats_store(&stats->vectors, atomic_load_explicit(&stats->vectors, memory_order_relaxed) + 1);
+    tide_stats_store(&stats->samples, atomic_load_explicit(&stats->samples, memory_order_relaxed) + (uint64_t)sampleframes);
+    tide_stats_store(&stats->total, atomic_load_explicit(&stats->total, memory_order_relaxed) + cost);
+    if (cost < atomic_load_explicit(&stats->min, memory_order_relaxed)) {
+        tide_stats_store(&stats->min, cost);
+    }
+    if (cost > atomic_load_explicit(&stats->max, memory_order_relaxed)) {
+        tide_stats_store(&stats->max, cost);
+    }
+    
+    _Atomic uint32_t* bucket = &stats->histogram[tide_stats_bucket(cost)];
+    atomic_store_explicit(bucket, atomic_load_explicit(bucket, memory_order_relaxed) + 1, memory_order_relaxed);
+    
+    atomic_store_explicit(&stats->resets, hot->stat_resets, memory_order_relaxed);
+    atomic_store_explicit(&stats->clamps_signal, hot->stat_clamps, memory_order_relaxed);
+    
+#if TIDES_STAGE_PROFILING
+    tides_stage_profile profile;
+    tides_get_stage_profile(tide_generator(x), &profile);
+    tide_stats_store(&stats->stage_samples, profile.samples);
+    tide_stats_store(&stats->stage_ramp, profile.ramp);
+    tide_stats_store(&stats->stage_shaping, profile.shaping);
+    tide_stats_store(&stats->stage_smoothing, profile.smoothing);
+    for (int i = 0; i < TIDES_SHAPE_REGIONS; i++) {
+        tide_stats_store(&stats->shape_regions[i], profile.shape_samples[i]);
+    }
+    for (int i = 0; i < TIDES_SMOOTH_REGIONS; i++) {
+        tide_stats_store(&stats->smooth_regions[i], profile.smooth_samples[i]);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_stats_clear(t_tide* x)
+{
+    // Audio thread, or tide_new before the object is in a chain
+    t_tide_stats* stats = &x->stats;
+    t_tide_hot* hot = tide_hot(x);
+    
+    hot->stat_resets = 0;
+    hot->stat_clamps = 0;
+    tide_stats_store(&stats->vectors, 0);
+    tide_stats_store(&stats->samples, 0);
+    tide_stats_store(&stats->total, 0);
+    tide_stats_store(&stats->min, UINT64_MAX);
+    tide_stats_store(&stats->max, 0);
+    atomic_store_explicit(&stats->resets, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats->clamps_signal, 0, memory_order_relaxed);
+    atomic_store_explicit(&stats->clamps_message, 0, memory_order_relaxed);
+    for (int i = 0; i < TIDE_STATS_BUCKETS; i++) {
+        atomic_store_explicit(&stats->histogram[i], 0, memory_order_relaxed);
+    }
+    
+#if TIDES_STAGE_PROFILING
+    tides_clear_stage_profile(tide_generator(x));
+    tide_stats_store(&stats->stage_samples, 0);
+    tide_stats_store(&stats->stage_ramp, 0);
+    tide_stats_store(&stats->stage_shaping, 0);
+    tide_stats_store(&stats->stage_smoothing, 0);
+    for (int i = 0; i < TIDES_SHAPE_REGIONS; i++) {
+        tide_stats_store(&stats->shape_regions[i], 0);
+    }
+    for (int i = 0; i < TIDES_SMOOTH_REGIONS; i++) {
+        tide_stats_store(&stats->smooth_regions[i], 0);
+    }
+#endif
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_stats(t_tide* x, t_symbol* s, long argc, t_atom* argv)
+{
+    // "stats" sends the counters out the right outlet as a dictionary;
+    // "stats clear" zeroes them at the start of the next vector
+    t_tide_stats* stats = &x->stats;
+    
+    if (argc && atom_getsym(argv) == gensym("clear")) {
+        atomic_store_explicit(&stats->clear_pending, 1, memory_order_release);
+        return;
+    }
+    
+    uint32_t histogram[TIDE_STATS_BUCKETS];
+    uint64_t counted = 0;
+    for (int i = 0; i < TIDE_STATS_BUCKETS; i++) {
+        histogram[i] = atomic_load_explicit(&stats->histogram[i], memory_order_relaxed);
+        counted += histogram[i];
+    }
+    
+    uint64_t vectors = atomic_load_explicit(&stats->vectors, memory_order_relaxed);
+    uint64_t samples = atomic_load_explicit(&stats->samples, memory_order_relaxed);
+    uint64_t total = atomic_load_explicit(&stats->total, memory_order_relaxed);
+    uint64_t min = vectors ? atomic_load_explicit(&stats->min, memory_order_relaxed) : 0;
+    uint64_t max = atomic_load_explicit(&stats->max, memory_order_relaxed);
+    
+    // 99th percentile: top of the bucket holding it, capped at the exact maximum
+    uint64_t p99 = 0;
+    uint64_t rank = counted - counted / 100;
+    uint64_t seen = 0;
+    t_atom buckets[2 * TIDE_STATS_BUCKETS];
+    long num_atoms = 0;
+    for (int i = 0; i < TIDE_STATS_BUCKETS; i++) {
+        if (!histogram[i]) {
+            continue;
+        }
+        seen += histogram[i];
+        if (!p99 && seen >= rank) {
+            p99 = (i + 1 < TIDE_STATS_BUCKETS) ? tide_stats_bucket_floor(i + 1) - 1 : max;
+            p99 = (p99 < max) ? p99 : max;
+        }
+        atom_setlong(&buckets[num_atoms++], (t_atom_long)tide_stats_bucket_floor(i));
+        atom_setlong(&buckets[num_atoms++], (t_atom_long)histogram[i]);
+    }
+    
+    t_dictionary* d = dictionary_new();
+    if (!d) {
+        return;
+    }
+    dictionary_appendsym(d, gensym("unit"), gensym(TIDE_STATS_UNIT));
+    dictionary_appendlong(d, gensym("vectors"), (t_atom_long)vectors);
+    dictionary_appendlong(d, gensym("samples"), (t_atom_long)samples);
+    dictionary_appendlong(d, gensym("min"), (t_atom_long)min);
+    dictionary_appendfloat(d, gensym("mean"), vectors ? (double)total / (double)vectors : 0.0);
+    dictionary_appendlong(d, gensym("max"), (t_atom_long)max);
+    dictionary_appendlong(d, gensym("p99"), (t_atom_long)p99);
+    dictionary_appendfloat(d, gensym("per_sample"), samples ? (double)total / (double)samples : 0.0);
+    dictionary_appendlong(d, gensym("resets"), (t_atom_long)atomic_load_explicit(&stats->resets, memory_order_relaxed));
+    dictionary_appendlong(d, gensym("clamps_message"), (t_atom_long)atomic_load_explicit(&stats->clamps_message, memory_order_relaxed));
+    dictionary_appendlong(d, gensym("clamps_signal"), (t_atom_long)atomic_load_explicit(&stats->clamps_signal, memory_order_relaxed));
+    dictionary_appendatoms(d, gensym("histogram"), num_atoms, buckets);  // Bucket floor, count pairs
+    
+#if TIDES_STAGE_PROFILING
+    // Stage breakdown from the profiling build of the core, in its own clock units
+    tides_stage_profile profile;
+    t_atom regions[TIDES_SHAPE_REGIONS + TIDES_SMOOTH_REGIONS];
+    tides_get_stage_profile(NULL, &profile);    // Unit and clock cost; the counters come from the audio thread
+    dictionary_appendsym(d, gensym("stage_unit"), gensym(profile.unit));
+    dictionary_appendlong(d, gensym("stage_clock_overhead"), (t_atom_long)profile.clock_overhead);
+    dictionary_appendlong(d, gensym("stage_samples"), (t_atom_long)atomic_load_explicit(&stats->stage_samples, memory_order_relaxed));
+    dictionary_appendlong(d, gensym("stage_ramp"), (t_atom_long)atomic_load_explicit(&stats->stage_ramp, memory_order_relaxed));
+    dictionary_appendlong(d, gensym("stage_shaping"), (t_atom_long)atomic_load_explicit(&stats->stage_shaping, memory_order_relaxed));
+    dictionary_appendlong(d, gensym("stage_smoothing"), (t_atom_long)atomic_load_explicit(&stats->stage_smoothing, memory_order_relaxed));
+    for (int i = 0; i < TIDES_SHAPE_REGIONS; i++) {
+        atom_setlong(&regions[i], (t_atom_long)atomic_load_explicit(&stats->shape_regions[i], memory_order_relaxed));
+    }
+    dictionary_appendatoms(d, gensym("shape_regions"), TIDES_SHAPE_REGIONS, regions);      // Linear, exponential, logarithmic
+    for (int i = 0; i < TIDES_SMOOTH_REGIONS; i++) {
+        atom_setlong(&regions[i], (t_atom_long)atomic_load_explicit(&stats->smooth_regions[i], memory_order_relaxed));
+    }
+    dictionary_appendatoms(d, gensym("smooth_regions"), TIDES_SMOOTH_REGIONS, regions);    // None, filter, fold
+#endif
+    
+    t_symbol* name = NULL;
+    t_atom a;
+    d = dictobj_register(d, &name);
+    atom_setsym(&a, name);
+    outlet_anything(x->stats_outlet, gensym("dictionary"), 1, &a);
+    dictobj_release(d);
+}
+
+#endif // TIDE_ENABLE_STATS
+
+#if TIDE_ENABLE_TRACE
+
+//----------------------------------------------------------------------------------------------
+
+void tide_perform64_trace(t_tide* x, t_object* dsp64, double** ins, long numins, double** outs, long numouts, long sampleframes, long flags, void* userparam)
+{
+    if (!atomic_load_explicit(&tide_recorder.recording, memory_order_acquire)) {
+        x->trace_routine(x, dsp64, ins, numins, outs, numouts, sampleframes, flags, userparam);
+        return;
+    }
+    
+    uint64_t begin = tide_trace_clock();
+    x->trace_routine(x, dsp64, ins, numins, outs, numouts, sampleframes, flags, userparam);
+    tide_trace_record(x, begin, tide_trace_clock(), sampleframes);
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_trace_record(t_tide* x, uint64_t begin, uint64_t end, long sampleframes)
+{
+    // Audio thread, while recording. The thread's ring is claimed on its first
+    // vector of each session; threads beyond TIDE_TRACE_THREADS are only counted.
+    unsigned int session = atomic_load_explicit(&tide_recorder.session, memory_order_relaxed);
+    if (tide_trace_session_local != session) {
+        unsigned int claimed = atomic_fetch_add_explicit(&tide_recorder.rings_claimed, 1, memory_order_relaxed);
+        tide_trace_ring_local = (claimed < TIDE_TRACE_THREADS) ? &tide_recorder.rings[claimed] : NULL;
+        tide_trace_session_local = session;
+    }
+    
+    t_tide_trace_ring* ring = tide_trace_ring_local;
+    if (!ring) {
+        atomic_fetch_add_explicit(&tide_recorder.dropped, 1, memory_order_relaxed);
+        return;
+    }
+    
+    uint64_t index = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    t_tide_trace_event* event = &ring->events[index & (TIDE_TRACE_EVENTS - 1)];
+    uint64_t duration = end - begin;
+    
+    atomic_store_explicit(&event->sequence, 0, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    atomic_store_explicit(&event->begin, begin - tide_recorder.origin, memory_order_relaxed);
+    atomic_store_explicit(&event->duration, (uint32_t)(duration < UINT32_MAX ? duration : UINT32_MAX), memory_order_relaxed);
+    atomic_store_explicit(&event->instance, x->trace_id, memory_order_relaxed);
+    atomic_store_explicit(&event->vector_size, (uint32_t)sampleframes, memory_order_relaxed);
+    atomic_store_explicit(&event->kernel, (uint32_t)x->trace_kernel, memory_order_relaxed);
+    atomic_store_explicit(&event->sequence, index + 1, memory_order_release);
+    atomic_store_explicit(&ring->head, index + 1, memory_order_release);
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_trace(t_tide* x, t_symbol* s, long argc, t_atom* argv)
+{
+    // "trace start" records the perform calls of every instance; "trace stop <file>"
+    // ends the recording and writes it as Chrome trace JSON from a background thread
+    t_tide_trace* recorder = &tide_recorder;
+    t_symbol* command = argc ? atom_getsym(argv) : NULL;
+    
+    if (command == gensym("start")) {
+        if (atomic_load_explicit(&recorder->recording, memory_order_relaxed)) {
+            post("tide~: trace already recording");
+            return;
+        }
+        if (atomic_load_explicit(&recorder->writing, memory_order_acquire)) {
+            post("tide~: trace still writing %s", recorder->path);
+            return;
+        }
+        if (recorder->writer) {
+            systhread_join(recorder->writer, NULL);
+            recorder->writer = NULL;
+        }
+        if (!recorder->rings) {
+            recorder->rings = (t_tide_trace_ring*)sysmem_newptrclear((long)(TIDE_TRACE_THREADS * sizeof(t_tide_trace_ring)));
+            if (!recorder->rings) {
+                post("tide~: trace: out of memory");
+                return;
+            }
+        }
+        
+        for (int i = 0; i < TIDE_TRACE_THREADS; i++) {
+            atomic_store_explicit(&recorder->rings[i].head, 0, memory_order_relaxed);
+        }
+        atomic_store_explicit(&recorder->rings_claimed, 0, memory_order_relaxed);
+        atomic_store_explicit(&recorder->dropped, 0, memory_order_relaxed);
+        atomic_fetch_add_explicit(&recorder->session, 1, memory_order_relaxed);
+        recorder->origin = tide_trace_clock();
+        atomic_store_explicit(&recorder->recording, 1, memory_order_release);
+        post("tide~: trace started");
+    }
+    else if (command == gensym("stop") && argc > 1) {
+        if (!atomic_load_explicit(&recorder->recording, memory_order_relaxed)) {
+            post("tide~: trace not recording");
+            return;
+        }
+        if (path_nameconform(atom_getsym(argv + 1)->s_name, recorder->path, PATH_STYLE_NATIVE, PATH_TYPE_BOOT)) {
+            post("tide~: trace: bad file name %s", atom_getsym(argv + 1)->s_name);
+            return;
+        }
+        
+        atomic_store_explicit(&recorder->recording, 0, memory_order_seq_cst);
+        atomic_store_explicit(&recorder->writing, 1, memory_order_relaxed);
+        if (systhread_create((method)tide_trace_write, recorder, 0, 0, 0, &recorder->writer)) {
+            recorder->writer = NULL;
+            atomic_store_explicit(&recorder->writing, 0, memory_order_relaxed);
+            post("tide~: trace: could not start the writer thread");
+        }
+    }
+    else {
+        post("tide~: trace expects start or stop <file>");
+    }
+}
+
+//----------------------------------------------------------------------------------------------
+
+void* tide_trace_write(void* arg)
+{
+    // Writer thread. Recording is off, but an audio thread may still be finishing
+    // the vector it was timing, so events are only written when their sequence
+    // shows them complete and unchanged by the copy.
+    t_tide_trace* recorder = (t_tide_trace*)arg;
+    FILE* file = fopen(recorder->path, "w");
+    
+    if (!file) {
+        post("tide~: trace: cannot open %s", recorder->path);
+        atomic_store_explicit(&recorder->writing, 0, memory_order_release);
+        return NULL;
+    }
+    
+    static const char* kernels[] = { "perform64", "perform64_small" };
+    unsigned int rings = atomic_load_explicit(&recorder->rings_claimed, memory_order_relaxed);
+    unsigned long long written = 0;
+    unsigned long long overwritten = 0;
+    
+    rings = (rings < TIDE_TRACE_THREADS) ? rings : TIDE_TRACE_THREADS;
+    fprintf(file, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"tide~\"}}");
+    
+    for (unsigned int r = 0; r < rings; r++) {
+        t_tide_trace_ring* ring = &recorder->rings[r];
+        uint64_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+        uint64_t first = (head > TIDE_TRACE_EVENTS) ? head - TIDE_TRACE_EVENTS : 0;
+        
+        overwritten += first;
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"audio thread %u\"}}",
+                r + 1, r + 1);
+        
+        for (uint64_t i = first; i < head; i++) {
+            t_tide_trace_event* event = &ring->events[i & (TIDE_TRACE_EVENTS - 1)];
+            uint64_t sequence = atomic_load_explicit(&event->sequence, memory_order_acquire);
+            uint64_t begin = atomic_load_explicit(&event->begin, memory_order_relaxed);
+            uint32_t duration = atomic_load_explicit(&event->duration, memory_order_relaxed);
+            uint32_t instance = atomic_load_explicit(&event->instance, memory_order_relaxed);
+            uint32_t vector_size = atomic_load_explicit(&event->vector_size, memory_order_relaxed);
+            uint32_t kernel = atomic_load_explicit(&event->kernel, memory_order_relaxed);
+            atomic_thread_fence(memory_order_acquire);
+            
+            if (sequence != i + 1 || atomic_load_explicit(&event->sequence, memory_order_relaxed) != sequence) {
+                continue;
+            }
+            // Complete events ("X"), timestamps in microseconds
+            fprintf(file, ",\n{\"name\":\"%s\",\"cat\":\"tide~\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f,"
+                          "\"args\":{\"instance\":%u,\"vector\":%u}}",
+                    kernels[kernel < 2 ? kernel : 0], r + 1, (double)begin / 1000.0, (double)duration / 1000.0,
+                    instance, vector_size);
+            written++;
+        }
+    }
+    
+    fprintf(file, "\n],\"otherData\":{\"events\":%llu,\"overwritten\":%llu,\"dropped\":%u}}\n",
+            written, overwritten, atomic_load_explicit(&recorder->dropped, memory_order_relaxed));
+    
+    int failed = ferror(file);
+    failed |= fclose(file);
+    if (failed) {
+        post("tide~: trace: error writing %s", recorder->path);
+    }
+    else {
+        post("tide~: trace: %llu events written to %s", written, recorder->path);
+    }
+    atomic_store_explicit(&recorder->writing, 0, memory_order_release);
+    return NULL;
+}
+
+//----------------------------------------------------------------------------------------------
+
+void tide_trace_quit(void* arg)
+{
+    // Let a trace being written finish before the application exits
+    atomic_store_explicit(&tide_recorder.recording, 0, memory_order_seq_cst);
+    if (tide_recorder.writer) {
+        systhread_join(tide_recorder.writer, NULL);
+        tide_recorder.writer = NULL;
+    }
+    if (tide_recorder.rings) {
+        sysmem_freeptr(tide_recorder.rings);
+        tide_recorder.rings = NULL;
+    }
+}
+
+#endif // TIDE_ENABLE_TRACE
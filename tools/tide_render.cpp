@@ -0,0 +1,527 @@
+/**
+ * tide-render: offline renderer for the Tides core
+ *
+ * Renders a PolySlopeGenerator to a mono 32-bit float WAV file (RF64 when the
+ * data passes 4 GB) or to raw native-endian floats, without Max. Output is
+ * produced in blocks and written as it is rendered, so memory use does not
+ * depend on the duration; "-" writes to stdout.
+ *
+ * Durations are a number with an optional unit, or several concatenated:
+ * 48000smp, 250ms, 10s (the default unit), 5m, 2h, 3d, 1d12h.
+ *
+ * A breakpoint file automates parameters. Each line holds a time, a
+ * parameter name and a value, and optionally "step":
+ *
+ *     # time   parameter  value
+ *     0        frequency  1
+ *     10m      frequency  20       # linear ramp from 0 to 10 minutes
+ *     1h       shape      0.8      # ramps from the command-line value
+ *     2h       slope      0.1 step # jumps at 2 hours
+ *
+ * A parameter ramps linearly from its previous point (its command-line value
+ * at time 0 when it has none) and holds after its last. Ramps are evaluated
+ * every --control samples; steps land on their exact sample.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tides_wrapper.h"
+
+namespace {
+
+enum Param {
+    PARAM_FREQUENCY,
+    PARAM_SHAPE,
+    PARAM_SLOPE,
+    PARAM_SMOOTH,
+    PARAM_PHASE,
+    PARAM_LAST
+};
+
+const char* const kParamNames[PARAM_LAST] = { "frequency", "shape", "slope", "smooth", "phase" };
+
+// Ramp modes of the core
+enum Mode {
+    MODE_AD = 0,
+    MODE_LOOP = 1,
+    MODE_AR = 2
+};
+
+const unsigned char kGateRising = 0x01;
+const unsigned char kGateHigh = 0x02;
+
+struct Breakpoint {
+    uint64_t sample;
+    double value;
+    bool step;
+};
+
+struct Options {
+    double values[PARAM_LAST];
+    Mode mode;
+    double sample_rate;
+    std::string duration;
+    std::string gate;               // AR gate length, the whole render by default
+    std::string breakpoints;
+    std::string output;
+    bool raw;
+    bool raw_set;
+    size_t block;
+    size_t control;
+    bool quiet;
+};
+
+void Usage() {
+    fprintf(stderr,
+        "usage: tide-render -d duration -o file [options]\n"
+        "  -f, --frequency hz     frequency in Hz (1)\n"
+        "      --shape 0-1        (0)\n"
+        "      --slope 0-1        (0.5)\n"
+        "      --smooth 0-1       (0)\n"
+        "      --phase 0-1        phase offset (0)\n"
+        "  -m, --mode loop|ad|ar  ramp mode (loop); ad and ar start triggered\n"
+        "      --gate duration    ar gate length (whole render)\n"
+        "  -d, --duration d       e.g. 48000smp, 250ms, 10s, 5m, 2h, 3d, 1d12h\n"
+        "  -r, --sample-rate hz   (48000)\n"
+        "  -b, --breakpoints file parameter automation\n"
+        "  -o, --output file      .wav, or raw floats with --format raw; - for stdout\n"
+        "      --format wav|raw   (from the extension, else wav)\n"
+        "      --block n          samples per render block (65536)\n"
+        "      --control n        samples between ramp updates (64)\n"
+        "  -q, --quiet\n");
+}
+
+bool ParseNumber(const char* text, double* value) {
+    char* end;
+    errno = 0;
+    *value = strtod(text, &end);
+    return end != text && *end == '\0' && errno == 0 && std::isfinite(*value);
+}
+
+// Parses a duration into samples; a plain number is in seconds
+bool ParseDuration(const char* text, double sample_rate, uint64_t* samples) {
+    double seconds = 0.0;
+    double frames = 0.0;
+    const char* p = text;
+    if (!*p) return false;
+
+    while (*p) {
+        char* end;
+        double amount = strtod(p, &end);
+        if (end == p || !std::isfinite(amount) || amount < 0.0) return false;
+        p = end;
+
+        size_t unit_length = 0;
+        while (p[unit_length] && !(p[unit_length] >= '0' && p[unit_length] <= '9') && p[unit_length] != '.') {
+            unit_length++;
+        }
+        std::string unit(p, unit_length);
+        p += unit_length;
+
+        if (unit == "smp") {
+            frames += amount;
+        } else if (unit.empty() || unit == "s") {
+            seconds += amount;
+        } else if (unit == "ms") {
+            seconds += amount / 1000.0;
+        } else if (unit == "m" || unit == "min") {
+            seconds += amount * 60.0;
+        } else if (unit == "h") {
+            seconds += amount * 3600.0;
+        } else if (unit == "d") {
+            seconds += amount * 86400.0;
+        } else {
+            return false;
+        }
+    }
+
+    double total = std::floor(frames + seconds * sample_rate + 0.5);
+    if (total > 9.0e18) return false;
+    *samples = (uint64_t)total;
+    return true;
+}
+
+int FindParam(const char* name) {
+    for (int i = 0; i < PARAM_LAST; i++) {
+        if (strcmp(name, kParamNames[i]) == 0) return i;
+    }
+    return -1;
+}
+
+bool LoadBreakpoints(const Options& options, std::vector<Breakpoint>* lanes) {
+    FILE* file = fopen(options.breakpoints.c_str(), "r");
+    if (!file) {
+        fprintf(stderr, "tide-render: cannot open %s: %s\n", options.breakpoints.c_str(), strerror(errno));
+        return false;
+    }
+
+    char line[512];
+    int line_number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file)) {
+        line_number++;
+        char* comment = strchr(line, '#');
+        if (comment) *comment = '\0';
+
+        char time[128], name[64], value[64], flag[16];
+        int fields = sscanf(line, "%127s %63s %63s %15s", time, name, value, flag);
+        if (fields <= 0) continue;
+
+        Breakpoint point;
+        int param = fields >= 3 ? FindParam(name) : -1;
+        point.step = fields == 4 && strcmp(flag, "step") == 0;
+        if (fields < 3 || param < 0 || (fields == 4 && !point.step)
+            || !ParseDuration(time, options.sample_rate, &point.sample)
+            || !ParseNumber(value, &point.value)) {
+            fprintf(stderr, "tide-render: %s:%d: expected \"time parameter value [step]\"\n",
+                    options.breakpoints.c_str(), line_number);
+            ok = false;
+            break;
+        }
+        lanes[param].push_back(point);
+    }
+    fclose(file);
+    if (!ok) return false;
+
+    for (int i = 0; i < PARAM_LAST; i++) {
+        std::vector<Breakpoint>& lane = lanes[i];
+        std::stable_sort(lane.begin(), lane.end(),
+                         [](const Breakpoint& a, const Breakpoint& b) { return a.sample < b.sample; });
+        // The command-line value is the starting point
+        if (lane.empty() || lane[0].sample > 0) {
+            Breakpoint start = { 0, options.values[i], true };
+            lane.insert(lane.begin(), start);
+        }
+    }
+    return true;
+}
+
+// One automated parameter, read forward through the render
+class Lane {
+public:
+    explicit Lane(const std::vector<Breakpoint>* points) : points_(points), index_(0) { }
+
+    // Moves to the segment holding sample
+    void Seek(uint64_t sample) {
+        while (index_ + 1 < points_->size() && (*points_)[index_ + 1].sample <= sample) {
+            index_++;
+        }
+    }
+
+    double Value(uint64_t sample) const {
+        const Breakpoint& a = (*points_)[index_];
+        if (!Ramping()) return a.value;
+        const Breakpoint& b = (*points_)[index_ + 1];
+        double t = (double)(sample - a.sample) / (double)(b.sample - a.sample);
+        return a.value + (b.value - a.value) * t;
+    }
+
+    bool Ramping() const {
+        if (index_ + 1 >= points_->size()) return false;
+        const Breakpoint& b = (*points_)[index_ + 1];
+        return !b.step && b.value != (*points_)[index_].value;
+    }
+
+    uint64_t NextChange() const {
+        return index_ + 1 < points_->size() ? (*points_)[index_ + 1].sample : UINT64_MAX;
+    }
+
+private:
+    const std::vector<Breakpoint>* points_;
+    size_t index_;
+};
+
+//----------------------------------------------------------------------------------------------
+
+void PutU16(unsigned char* p, uint32_t v) {
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+void PutU32(unsigned char* p, uint32_t v) {
+    PutU16(p, v & 0xFFFF);
+    PutU16(p + 2, v >> 16);
+}
+
+void PutU64(unsigned char* p, uint64_t v) {
+    PutU32(p, (uint32_t)v);
+    PutU32(p + 4, (uint32_t)(v >> 32));
+}
+
+// Float WAV header for a known length. It reserves a JUNK chunk that becomes
+// the RF64 ds64 chunk when the sizes overflow 32 bits, so either form is
+// written in one pass and stdout works.
+bool WriteWavHeader(FILE* out, uint64_t frames, double sample_rate) {
+    enum { kHeaderSize = 94 };
+    unsigned char h[kHeaderSize];
+    memset(h, 0, sizeof(h));
+
+    uint64_t data_size = frames * 4;
+    uint64_t riff_size = kHeaderSize - 8 + data_size;
+    bool rf64 = riff_size > 0xFFFFFFFFull;
+    uint32_t rate = (uint32_t)std::floor(sample_rate + 0.5);
+
+    memcpy(h, rf64 ? "RF64" : "RIFF", 4);
+    PutU32(h + 4, rf64 ? 0xFFFFFFFF : (uint32_t)riff_size);
+    memcpy(h + 8, "WAVE", 4);
+
+    memcpy(h + 12, rf64 ? "ds64" : "JUNK", 4);
+    PutU32(h + 16, 28);
+    if (rf64) {
+        PutU64(h + 20, riff_size);
+        PutU64(h + 28, data_size);
+        PutU64(h + 36, frames);
+        PutU32(h + 44, 0);          // No table entries
+    }
+
+    memcpy(h + 48, "fmt ", 4);
+    PutU32(h + 52, 18);
+    PutU16(h + 56, 3);              // WAVE_FORMAT_IEEE_FLOAT
+    PutU16(h + 58, 1);              // Mono
+    PutU32(h + 60, rate);
+    PutU32(h + 64, rate * 4);
+    PutU16(h + 68, 4);
+    PutU16(h + 70, 32);
+    PutU16(h + 72, 0);
+
+    memcpy(h + 74, "fact", 4);
+    PutU32(h + 78, 4);
+    PutU32(h + 82, rf64 ? 0xFFFFFFFF : (uint32_t)frames);
+
+    memcpy(h + 86, "data", 4);
+    PutU32(h + 90, rf64 ? 0xFFFFFFFF : (uint32_t)data_size);
+
+    return fwrite(h, 1, sizeof(h), out) == sizeof(h);
+}
+
+// Writes floats little-endian, whatever the host
+bool WriteWavSamples(FILE* out, const float* samples, size_t count, std::vector<unsigned char>* scratch) {
+    const uint16_t probe = 1;
+    if (*(const unsigned char*)&probe == 1) {
+        return fwrite(samples, sizeof(float), count, out) == count;
+    }
+    scratch->resize(count * 4);
+    for (size_t i = 0; i < count; i++) {
+        uint32_t bits;
+        memcpy(&bits, &samples[i], 4);
+        PutU32(scratch->data() + i * 4, bits);
+    }
+    return fwrite(scratch->data(), 1, scratch->size(), out) == scratch->size();
+}
+
+bool Write(FILE* out, bool raw, const float* samples, size_t count, std::vector<unsigned char>* scratch) {
+    if (raw) {
+        return fwrite(samples, sizeof(float), count, out) == count;
+    }
+    return WriteWavSamples(out, samples, count, scratch);
+}
+
+//----------------------------------------------------------------------------------------------
+
+bool ParseArgs(int argc, char** argv, Options* options) {
+    options->values[PARAM_FREQUENCY] = 1.0;
+    options->values[PARAM_SHAPE] = 0.0;
+    options->values[PARAM_SLOPE] = 0.5;
+    options->values[PARAM_SMOOTH] = 0.0;
+    options->values[PARAM_PHASE] = 0.0;
+    options->mode = MODE_LOOP;
+    options->sample_rate = 48000.0;
+    options->raw = false;
+    options->raw_set = false;
+    options->block = 65536;
+    options->control = 64;
+    options->quiet = false;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-q" || arg == "--quiet") {
+            options->quiet = true;
+            continue;
+        }
+        if (arg == "-h" || arg == "--help" || i + 1 >= argc) {
+            return false;
+        }
+        const char* value = argv[++i];
+        double number = 0.0;
+        bool numeric = ParseNumber(value, &number);
+
+        int param = arg.compare(0, 2, "--") == 0 ? FindParam(arg.c_str() + 2) : -1;
+        if (arg == "-f") param = PARAM_FREQUENCY;
+
+        if (param >= 0) {
+            if (!numeric) return false;
+            options->values[param] = number;
+        } else if (arg == "-m" || arg == "--mode") {
+            if (strcmp(value, "loop") == 0) options->mode = MODE_LOOP;
+            else if (strcmp(value, "ad") == 0) options->mode = MODE_AD;
+            else if (strcmp(value, "ar") == 0) options->mode = MODE_AR;
+            else return false;
+        } else if (arg == "--gate") {
+            options->gate = value;
+        } else if (arg == "-d" || arg == "--duration") {
+            options->duration = value;
+        } else if (arg == "-r" || arg == "--sample-rate") {
+            if (!numeric || number < 1.0 || number > 4.0e9) return false;
+            options->sample_rate = number;
+        } else if (arg == "-b" || arg == "--breakpoints") {
+            options->breakpoints = value;
+        } else if (arg == "-o" || arg == "--output") {
+            options->output = value;
+        } else if (arg == "--format") {
+            if (strcmp(value, "raw") != 0 && strcmp(value, "wav") != 0) return false;
+            options->raw = strcmp(value, "raw") == 0;
+            options->raw_set = true;
+        } else if (arg == "--block" || arg == "--control") {
+            if (!numeric || number < 1.0 || number > 16777216.0) return false;
+            (arg == "--block" ? options->block : options->control) = (size_t)number;
+        } else {
+            return false;
+        }
+    }
+
+    if (!options->raw_set) {
+        const std::string& o = options->output;
+        options->raw = o.size() > 4 && o.compare(o.size() - 4, 4, ".raw") == 0;
+    }
+    return !options->duration.empty() && !options->output.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!ParseArgs(argc, argv, &options)) {
+        Usage();
+        return 2;
+    }
+
+    uint64_t total = 0;
+    uint64_t gate_end = UINT64_MAX;
+    if (!ParseDuration(options.duration.c_str(), options.sample_rate, &total)) {
+        fprintf(stderr, "tide-render: bad duration \"%s\"\n", options.duration.c_str());
+        return 2;
+    }
+    if (!options.gate.empty() && !ParseDuration(options.gate.c_str(), options.sample_rate, &gate_end)) {
+        fprintf(stderr, "tide-render: bad gate length \"%s\"\n", options.gate.c_str());
+        return 2;
+    }
+
+    std::vector<Breakpoint> points[PARAM_LAST];
+    if (!options.breakpoints.empty()) {
+        if (!LoadBreakpoints(options, points)) return 1;
+    } else {
+        for (int i = 0; i < PARAM_LAST; i++) {
+            Breakpoint start = { 0, options.values[i], true };
+            points[i].push_back(start);
+        }
+    }
+    std::vector<Lane> lanes;
+    for (int i = 0; i < PARAM_LAST; i++) {
+        lanes.push_back(Lane(&points[i]));
+    }
+
+    bool to_stdout = options.output == "-";
+    FILE* out = to_stdout ? stdout : fopen(options.output.c_str(), "wb");
+    if (!out) {
+        fprintf(stderr, "tide-render: cannot open %s: %s\n", options.output.c_str(), strerror(errno));
+        return 1;
+    }
+    if (!options.raw && !WriteWavHeader(out, total, options.sample_rate)) {
+        fprintf(stderr, "tide-render: write failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    void* generator = tides_create();
+    if (!generator) {
+        fprintf(stderr, "tide-render: out of memory\n");
+        return 1;
+    }
+    tides_init(generator);
+
+    std::vector<double> block(options.block);
+    std::vector<float> samples(options.block);
+    std::vector<unsigned char> scratch;
+    size_t pending = 0;
+    bool ok = true;
+
+    uint64_t position = 0;
+    while (ok && position < total) {
+        // The chunk ends at the block size, the next breakpoint or gate edge,
+        // and the next control tick while anything is ramping
+        uint64_t end = std::min<uint64_t>(total, position + options.block);
+        bool ramping = false;
+        double values[PARAM_LAST];
+        for (int i = 0; i < PARAM_LAST; i++) {
+            lanes[i].Seek(position);
+            values[i] = lanes[i].Value(position);
+            ramping = ramping || lanes[i].Ramping();
+            end = std::min(end, lanes[i].NextChange());
+        }
+        if (ramping) {
+            end = std::min<uint64_t>(end, position + options.control);
+        }
+        if (options.mode == MODE_AR && position < gate_end) {
+            end = std::min(end, gate_end);
+        }
+
+        // Same conversions as tide~'s inlets
+        float frequency = (float)(std::max(values[PARAM_FREQUENCY], 0.0) / options.sample_rate);
+        frequency = std::min(frequency, 0.5f);
+        float shape = (float)std::min(std::max(values[PARAM_SHAPE], 0.0), 1.0);
+        float slope = (float)std::min(std::max(values[PARAM_SLOPE], 0.0), 1.0);
+        float smooth = (float)std::min(std::max(values[PARAM_SMOOTH], 0.0), 1.0);
+        float phase = (float)std::min(std::max(values[PARAM_PHASE], 0.0), 1.0);
+
+        unsigned char gate = options.mode == MODE_AR && position < gate_end ? kGateHigh : 0;
+        size_t count = (size_t)(end - position);
+        size_t offset = 0;
+
+        if (position == 0 && options.mode != MODE_LOOP) {
+            // Trigger on the first sample
+            float first[4];
+            tides_render(generator, options.mode, 1, 1, frequency, slope, shape, smooth, phase,
+                         kGateRising | kGateHigh, first);
+            block[0] = (double)first[0];
+            offset = 1;
+        }
+        tides_render_block(generator, options.mode, 1, 1, frequency, slope, shape, smooth, phase,
+                           gate, block.data() + offset, count - offset);
+
+        // Short ramp chunks are gathered so writes stay block sized
+        if (pending + count > samples.size()) {
+            ok = Write(out, options.raw, samples.data(), pending, &scratch);
+            pending = 0;
+        }
+        for (size_t i = 0; i < count; i++) {
+            samples[pending + i] = (float)block[i];
+        }
+        pending += count;
+        position = end;
+    }
+
+    if (ok) {
+        ok = Write(out, options.raw, samples.data(), pending, &scratch);
+    }
+    tides_destroy(generator);
+    if (fflush(out) != 0) ok = false;
+    if (!to_stdout && fclose(out) != 0) ok = false;
+    if (!ok) {
+        fprintf(stderr, "tide-render: write failed: %s\n", strerror(errno));
+        return 1;
+    }
+
+    if (!options.quiet) {
+        fprintf(stderr, "tide-render: %llu samples (%.3f s) to %s\n",
+                (unsigned long long)total, (double)total / options.sample_rate,
+                to_stdout ? "stdout" : options.output.c_str());
+    }
+    return 0;
+}